@@ -0,0 +1,122 @@
+// benchutil.h
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+// Shared by the benchmarks in this directory. Each one is a standalone
+// program built from its own .cpp and the library sources, never with
+// main.cpp or cdrannotator.cpp, for example from this directory:
+//   g++ -std=c++17 -O2 -pthread -I.. searchbench.cpp ../birthdate.cpp
+//       ../collation.cpp ../contact.cpp ../idindex.cpp ../numberingplan.cpp
+//       ../orderedindex.cpp ../parallelsort.cpp ../phonebook.cpp
+//       ../phoneindex.cpp ../phonenumber.cpp ../searchkeybuffer.cpp
+//       ../stringpool.cpp ../substringscan.cpp ../taskpool.cpp
+//       ../trigramindex.cpp ../validator.cpp
+// This header replaces the global operator new to count heap allocations, so
+// it goes into exactly one file per program.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+
+namespace bench {
+
+inline std::atomic<uint64_t> allocations(0);
+inline std::atomic<uint64_t> allocatedBytes(0);
+
+inline void resetAllocations() {
+    allocations = 0;
+    allocatedBytes = 0;
+}
+
+typedef std::chrono::steady_clock Clock;
+
+inline double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+inline size_t sizeArgument(int argc, char** argv, int index, size_t fallback) {
+    if (argc <= index) return fallback;
+    char* end;
+    unsigned long long value = std::strtoull(argv[index], &end, 10);
+    return *end == '\0' && value > 0 ? static_cast<size_t>(value) : fallback;
+}
+
+// A saveToFile line for contact i. Names come from small pools, half of them
+// in Cyrillic (CP1251), so names repeat the way real ones do while last
+// names, emails and phones stay mostly distinct.
+inline std::string contactLine(size_t i) {
+    static const char* const firstNames[] = {
+        "Ivan", "Anna", "Oleg", "Maria", "Sergey", "Olga", "Dmitry", "Irina",
+        "\xC8\xE2\xE0\xED", "\xC0\xED\xED\xE0", "\xCE\xEB\xE5\xE3", "\xCC\xE0\xF0\xE8\xFF",
+        "\xD1\xE5\xF0\xE3\xE5\xE9", "\xCE\xEB\xFC\xE3\xE0", "\xC4\xEC\xE8\xF2\xF0\xE8\xE9", "\xC8\xF0\xE8\xED\xE0",
+    };
+    static const char* const syllables[] = {
+        "Ku", "Pe", "Si", "Vo", "Ma", "Le", "Bo", "Ro", "Za", "Te", "Mi", "No", "Ga", "Fe", "Do", "Ly",
+    };
+    static const char* const endings[] = {"rov", "nov", "kin", "shev", "lin", "tsov", "din", "mov"};
+    static const char* const domains[] = {"mail.ru", "yandex.ru", "gmail.com", "inbox.ru", "bk.ru", "list.ru"};
+
+    uint64_t h = (i + 1) * 0x9E3779B97F4A7C15ull;
+    h ^= h >> 29;
+    std::string last = std::string(syllables[h % 16]) + syllables[(h >> 4) % 16] + syllables[(h >> 8) % 16] +
+                       endings[(h >> 12) % 8];
+    std::string email = last + std::to_string(i) + "@" + domains[(h >> 15) % 6];
+    for (auto& c : email) {
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    }
+    std::string date = std::to_string(1940 + (h >> 18) % 80) + "-" + std::to_string(1 + (h >> 25) % 12) + "-" +
+                       std::to_string(1 + (h >> 29) % 28);
+    std::string phone = "+79" + std::to_string(100000000 + (h >> 32) % 900000000);
+    return std::string(firstNames[(h >> 20) % 16]) + ";" + last + ";;" + "Street " + std::to_string((h >> 40) % 500) +
+           ";" + date + ";" + email + ";phones:(0," + phone + ")";
+}
+
+inline void writeBook(const std::string& path, size_t contacts) {
+    std::ofstream file(path, std::ios::binary);
+    for (size_t i = 0; i < contacts; ++i) file << contactLine(i) << "\n";
+}
+
+} // namespace bench
+
+void* operator new(size_t size) {
+    ++bench::allocations;
+    bench::allocatedBytes += size;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// std::pmr::new_delete_resource() allocates through these. The pointer malloc
+// returned is kept just below the aligned block.
+void* operator new(size_t size, std::align_val_t alignment) {
+    ++bench::allocations;
+    bench::allocatedBytes += size;
+    size_t align = static_cast<size_t>(alignment);
+    void* raw = std::malloc(size + align + sizeof(void*));
+    if (!raw) throw std::bad_alloc();
+    uintptr_t p = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + align - 1) & ~static_cast<uintptr_t>(align - 1);
+    reinterpret_cast<void**>(p)[-1] = raw;
+    return reinterpret_cast<void*>(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    if (p) std::free(static_cast<void**>(p)[-1]);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    if (p) std::free(static_cast<void**>(p)[-1]);
+}
+
+#endif
@@ -0,0 +1,65 @@
+// loadbench.cpp
+// Bulk load with and without the arena: parses the same lines with
+// Contact::parseTrusted into the default heap and into a monotonic buffer,
+// then times freeing each, and finally a whole PhoneBook load and clear.
+// Usage: loadbench [contacts=1000000]
+#include "benchutil.h"
+#include "phonebook.h"
+#include <cstdio>
+#include <memory_resource>
+#include <optional>
+
+static void parseInto(const std::vector<std::string>& lines, std::vector<Contact>& contacts,
+                      std::pmr::memory_resource* resource) {
+    for (const auto& line : lines) {
+        ParseResult parsed = Contact::parseTrusted(line, resource);
+        if (parsed) contacts.push_back(std::move(*parsed.contact));
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t count = bench::sizeArgument(argc, argv, 1, 1000000);
+    std::vector<std::string> lines;
+    lines.reserve(count);
+    for (size_t i = 0; i < count; ++i) lines.push_back(bench::contactLine(i));
+    std::printf("%zu contacts\n%-8s %14s %12s %10s %10s\n", count, "resource", "allocs", "MB", "parse ms", "free ms");
+
+    for (int pass = 0; pass < 2; ++pass) {
+        std::optional<std::pmr::monotonic_buffer_resource> arena;
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+        if (pass == 1) resource = &arena.emplace();
+        // Reserved up front so that both passes count only the contacts.
+        std::vector<Contact> contacts;
+        contacts.reserve(count);
+
+        bench::resetAllocations();
+        auto start = bench::Clock::now();
+        parseInto(lines, contacts, resource);
+        double parseMs = bench::millisecondsSince(start);
+        uint64_t allocs = bench::allocations;
+        uint64_t bytes = bench::allocatedBytes;
+
+        start = bench::Clock::now();
+        contacts.clear();
+        if (arena) arena->release();
+        double freeMs = bench::millisecondsSince(start);
+        std::printf("%-8s %14llu %12.1f %10.1f %10.1f\n", pass == 0 ? "heap" : "arena",
+                    static_cast<unsigned long long>(allocs), bytes / 1048576.0, parseMs, freeMs);
+    }
+
+    const std::string path = "loadbench.tmp";
+    bench::writeBook(path, count);
+    PhoneBook book;
+    bench::resetAllocations();
+    auto start = bench::Clock::now();
+    book.loadFromFile(path, LoadMode::Trusted);
+    double loadMs = bench::millisecondsSince(start);
+    uint64_t allocs = bench::allocations;
+    start = bench::Clock::now();
+    book.clearAllContacts();
+    double clearMs = bench::millisecondsSince(start);
+    std::remove(path.c_str());
+    std::printf("PhoneBook trusted load: %llu allocs, %.1f ms; clearAllContacts: %.1f ms\n",
+                static_cast<unsigned long long>(allocs), loadMs, clearMs);
+    return 0;
+}
@@ -0,0 +1,70 @@
+// scanbench.cpp
+// Brute-force search over folded contact keys: one SubstringScan pass over a
+// SearchKeyBuffer against the std::string::find per contact it replaced.
+// Usage: scanbench [largest=10000000]; runs 100k, 1M and 10M keys up to it.
+#include "benchutil.h"
+#include "searchkeybuffer.h"
+#include "validator.h"
+#include <cstdio>
+#include <vector>
+
+// The key Contact builds: "first last\nmiddle\nemail", case-folded.
+static std::string searchKey(const std::string& line) {
+    size_t fields[6];
+    size_t pos = 0;
+    for (size_t i = 0; i < 6; ++i) {
+        fields[i] = pos;
+        pos = line.find(';', pos) + 1;
+    }
+    std::string key;
+    Validator::appendFolded(key, std::string_view(line).substr(fields[0], fields[1] - fields[0] - 1));
+    key += ' ';
+    Validator::appendFolded(key, std::string_view(line).substr(fields[1], fields[2] - fields[1] - 1));
+    key += "\n\n";
+    Validator::appendFolded(key, std::string_view(line).substr(fields[5], pos - fields[5] - 1));
+    return key;
+}
+
+static void run(size_t contacts) {
+    std::vector<std::string> keys;
+    keys.reserve(contacts);
+    SearchKeyBuffer buffer;
+    for (size_t i = 0; i < contacts; ++i) {
+        keys.push_back(searchKey(bench::contactLine(i)));
+        buffer.add(i + 1, keys.back());
+    }
+
+    std::printf("%zu keys\n%-8s %14s %14s %8s\n", contacts, "query", "find: ms", "scan: ms", "hits");
+    // Labels are ASCII so that the table prints in any console.
+    const char* queries[][2] = {
+        {"a", "a"}, {"ov", "ov"}, {"\xE8\xE2", "iv (cyr)"}, {"17", "17"}, {"kupe", "kupe"}, {"zzzz", "zzzz"},
+    };
+    for (const auto& query : queries) {
+        std::string needle = Validator::foldCase(query[0]);
+
+        auto start = bench::Clock::now();
+        size_t before = 0;
+        for (const auto& key : keys) {
+            if (key.find(needle) != std::string::npos) ++before;
+        }
+        double beforeMs = bench::millisecondsSince(start);
+
+        start = bench::Clock::now();
+        size_t after = 0;
+        buffer.scan(needle, [&after](uint64_t, size_t) {
+            ++after;
+            return true;
+        });
+        double afterMs = bench::millisecondsSince(start);
+
+        if (before != after) std::printf("hit counts differ: %zu / %zu\n", before, after);
+        std::printf("%-8s %14.1f %14.1f %8zu\n", query[1], beforeMs, afterMs, after);
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t largest = bench::sizeArgument(argc, argv, 1, 10000000);
+    std::printf("kernel: %s\n", SubstringScan::implementation());
+    for (size_t contacts = 100000; contacts <= largest; contacts *= 10) run(contacts);
+    return 0;
+}
@@ -0,0 +1,59 @@
+// searchbench.cpp
+// Heap allocations and time per PhoneBook::search query, against the loop it
+// replaced, which copied and lower-cased the name and email of every contact.
+// Usage: searchbench [contacts=1000000]
+#include "benchutil.h"
+#include "phonebook.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+// The original search: two field copies plus two lower-cased copies per
+// contact. Matches are only counted, not copied out.
+static size_t copyingSearch(const PhoneBook& book, const std::string& query) {
+    std::string q = query;
+    std::transform(q.begin(), q.end(), q.begin(), ::tolower);
+    size_t hits = 0;
+    for (const auto& c : book.getContacts()) {
+        std::string name = std::string(c.getFirstName()) + " " + std::string(c.getLastName());
+        std::string email = c.getEmail();
+
+        std::string nameLower = name;
+        std::string emailLower = email;
+        std::transform(nameLower.begin(), nameLower.end(), nameLower.begin(), ::tolower);
+        std::transform(emailLower.begin(), emailLower.end(), emailLower.begin(), ::tolower);
+        if (nameLower.find(q) != std::string::npos || emailLower.find(q) != std::string::npos) ++hits;
+    }
+    return hits;
+}
+
+int main(int argc, char** argv) {
+    size_t contacts = bench::sizeArgument(argc, argv, 1, 1000000);
+    const std::string path = "searchbench.tmp";
+    bench::writeBook(path, contacts);
+    PhoneBook book;
+    book.loadFromFile(path, LoadMode::Trusted);
+    std::remove(path.c_str());
+    std::printf("%zu contacts\n", book.getContacts().size());
+    std::printf("%-10s %22s %22s\n", "query", "copying: allocs / ms", "search: allocs / ms");
+
+    const char* queries[] = {"ov", "ivan", "kupe", "gmail", "17@mail", "zzzz"};
+    for (const char* query : queries) {
+        bench::resetAllocations();
+        auto start = bench::Clock::now();
+        size_t before = copyingSearch(book, query);
+        double beforeMs = bench::millisecondsSince(start);
+        uint64_t beforeAllocs = bench::allocations;
+
+        bench::resetAllocations();
+        start = bench::Clock::now();
+        size_t after = book.search(query, 0, SIZE_MAX).size();
+        double afterMs = bench::millisecondsSince(start);
+        uint64_t afterAllocs = bench::allocations;
+
+        std::printf("%-10s %12llu / %7.1f %12llu / %7.1f   hits %zu / %zu\n", query,
+                    static_cast<unsigned long long>(beforeAllocs), beforeMs,
+                    static_cast<unsigned long long>(afterAllocs), afterMs, before, after);
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+// sortbench.cpp
+// Ordering a book by a text field: std::sort with comparators that copy the
+// field out of both contacts, as sortByField used to, against building one
+// collation key per contact and bulk-loading an OrderedIndex.
+// Usage: sortbench [contacts=1000000]
+#include "benchutil.h"
+#include "collation.h"
+#include "orderedindex.h"
+#include "phonebook.h"
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+
+// By-value getters, as Contact had them before the fields were interned.
+static std::string fieldOf(const Contact& c, SortField field) {
+    switch (field) {
+    case SortField::FirstName: return std::string(c.getFirstName());
+    case SortField::LastName: return std::string(c.getLastName());
+    default: return c.getEmail();
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t contacts = bench::sizeArgument(argc, argv, 1, 1000000);
+    const std::string path = "sortbench.tmp";
+    bench::writeBook(path, contacts);
+    PhoneBook book;
+    book.loadFromFile(path, LoadMode::Trusted);
+    std::remove(path.c_str());
+    const std::vector<Contact>& all = book.getContacts();
+    std::printf("%zu contacts\n", all.size());
+    std::printf("%-6s %24s %24s %24s\n", "field", "copying sort: allocs / ms", "build keys: allocs / ms",
+                "assign: allocs / ms");
+
+    const SortField fields[] = {SortField::FirstName, SortField::LastName, SortField::Email};
+    const char* names[] = {"first", "last", "email"};
+    for (int f = 0; f < 3; ++f) {
+        SortField field = fields[f];
+        std::vector<size_t> order(all.size());
+        std::iota(order.begin(), order.end(), 0);
+        bench::resetAllocations();
+        auto start = bench::Clock::now();
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            std::string x = fieldOf(all[a], field);
+            std::string y = fieldOf(all[b], field);
+            return std::lexicographical_compare(x.begin(), x.end(), y.begin(), y.end(),
+                [](char p, char q) { return static_cast<unsigned char>(p) < static_cast<unsigned char>(q); });
+        });
+        double sortMs = bench::millisecondsSince(start);
+        uint64_t sortAllocs = bench::allocations;
+
+        bench::resetAllocations();
+        start = bench::Clock::now();
+        std::vector<std::string> keys;
+        std::vector<uint64_t> ids;
+        keys.reserve(all.size());
+        ids.reserve(all.size());
+        for (const auto& c : all) {
+            keys.push_back(Collation::key(fieldOf(c, field)));
+            ids.push_back(c.getId());
+        }
+        double keysMs = bench::millisecondsSince(start);
+        uint64_t keysAllocs = bench::allocations;
+
+        bench::resetAllocations();
+        start = bench::Clock::now();
+        OrderedIndex index;
+        index.assign(std::move(keys), ids);
+        double assignMs = bench::millisecondsSince(start);
+        uint64_t assignAllocs = bench::allocations;
+
+        std::printf("%-6s %14llu / %7.1f %14llu / %7.1f %14llu / %7.1f\n", names[f],
+                    static_cast<unsigned long long>(sortAllocs), sortMs,
+                    static_cast<unsigned long long>(keysAllocs), keysMs,
+                    static_cast<unsigned long long>(assignAllocs), assignMs);
+    }
+    return 0;
+}
@@ -0,0 +1,322 @@
+// cdrannotator.cpp
+#include "cdrannotator.h"
+#include "validator.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Read-only file that hands out mapped views of byte ranges.
+class MappedFile {
+public:
+    class View {
+    public:
+        View() : base(nullptr), length(0), data(nullptr) {}
+        View(const View&) = delete;
+        View& operator=(const View&) = delete;
+        View(View&& other) noexcept { take(other); }
+        View& operator=(View&& other) noexcept {
+            if (this != &other) {
+                release();
+                take(other);
+            }
+            return *this;
+        }
+        ~View() { release(); }
+
+        const char* begin() const { return data; }
+
+    private:
+        friend class MappedFile;
+        void* base;
+        size_t length;
+        const char* data;
+
+        void take(View& other) {
+            base = other.base;
+            length = other.length;
+            data = other.data;
+            other.base = nullptr;
+            other.data = nullptr;
+            other.length = 0;
+        }
+
+        void release() {
+            if (!base) return;
+#ifdef _WIN32
+            UnmapViewOfFile(base);
+#else
+            munmap(base, length);
+#endif
+            base = nullptr;
+        }
+    };
+
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                           OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot open " + path);
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(file, &fileSize);
+        size = static_cast<uint64_t>(fileSize.QuadPart);
+        mapping = size ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+        if (size && !mapping) {
+            CloseHandle(file);
+            throw std::runtime_error("Cannot map " + path);
+        }
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        granularity = info.dwAllocationGranularity;
+#else
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open " + path);
+        struct stat st;
+        fstat(fd, &st);
+        size = static_cast<uint64_t>(st.st_size);
+        granularity = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+#else
+        ::close(fd);
+#endif
+    }
+
+    uint64_t fileSize() const { return size; }
+
+    View map(uint64_t offset, size_t length) const {
+        uint64_t aligned = offset - offset % granularity;
+        size_t span = static_cast<size_t>(offset - aligned) + length;
+        View view;
+#ifdef _WIN32
+        view.base = MapViewOfFile(mapping, FILE_MAP_READ, static_cast<DWORD>(aligned >> 32),
+                                  static_cast<DWORD>(aligned & 0xFFFFFFFFu), span);
+        if (!view.base) throw std::runtime_error("MapViewOfFile failed");
+#else
+        void* p = mmap(nullptr, span, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(aligned));
+        if (p == MAP_FAILED) throw std::runtime_error("mmap failed");
+        madvise(p, span, MADV_SEQUENTIAL);
+        view.base = p;
+#endif
+        view.length = span;
+        view.data = static_cast<const char*>(view.base) + (offset - aligned);
+        return view;
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+    uint64_t size;
+    uint64_t granularity;
+};
+
+std::string_view csvField(const char* first, const char* last, size_t column, char delimiter) {
+    for (size_t i = 1; i < column; ++i) {
+        const char* next = static_cast<const char*>(std::memchr(first, delimiter, last - first));
+        if (!next) return std::string_view();
+        first = next + 1;
+    }
+    const char* end = static_cast<const char*>(std::memchr(first, delimiter, last - first));
+    return std::string_view(first, (end ? end : last) - first);
+}
+
+} // namespace
+
+CdrAnnotator::CdrAnnotator(const PhoneBook& book, const AnnotateOptions& options)
+    : book(book), options(options)
+{
+    if (this->options.threads == 0) {
+        this->options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (this->options.chunkSize < 4096) this->options.chunkSize = 4096;
+}
+
+void CdrAnnotator::annotateChunk(const char* first, const char* last, std::string& out,
+                                 uint64_t& records, uint64_t& matched) const {
+    out.reserve(static_cast<size_t>(last - first) + (last - first) / 2);
+    const char* line = first;
+    while (line < last) {
+        const char* eol = static_cast<const char*>(std::memchr(line, '\n', last - line));
+        if (!eol) eol = last;
+        const char* end = (eol > line && eol[-1] == '\r') ? eol - 1 : eol;
+
+        if (end > line) {
+            std::string_view number = options.column == 0
+                ? std::string_view(line, end - line)
+                : csvField(line, end, options.column, options.delimiter);
+            const Contact* owner = book.findByPhoneKey(Validator::phoneKey(number));
+
+            out.append(line, end - line);
+            out += options.delimiter;
+            if (owner) {
+                out += owner->getLastName();
+                out += ' ';
+                out += owner->getFirstName();
+                if (!owner->getMiddleName().empty()) {
+                    out += ' ';
+                    out += owner->getMiddleName();
+                }
+                ++matched;
+            }
+            out += '\n';
+            ++records;
+        }
+        if (eol == last) break;
+        line = eol + 1;
+    }
+}
+
+AnnotateStats CdrAnnotator::run(const std::string& inputPath, const std::string& outputPath) const {
+    auto started = std::chrono::steady_clock::now();
+    MappedFile input(inputPath);
+    std::ofstream output(outputPath, std::ios::binary);
+    if (!output) throw std::runtime_error("Cannot open " + outputPath);
+
+    struct Chunk {
+        MappedFile::View view;
+        const char* first = nullptr;
+        const char* last = nullptr;
+        std::string text;
+        uint64_t records = 0;
+        uint64_t matched = 0;
+        bool done = false;
+    };
+
+    const size_t window = options.threads * 2;
+    std::vector<Chunk> ring(window);
+    std::deque<size_t> queue;
+    std::mutex mutex;
+    std::condition_variable workReady;
+    std::condition_variable chunkDone;
+    bool finished = false;
+
+    std::vector<std::thread> workers;
+    auto worker = [&]() {
+        while (true) {
+            size_t seq;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                workReady.wait(lock, [&]() { return finished || !queue.empty(); });
+                if (queue.empty()) return;
+                seq = queue.front();
+                queue.pop_front();
+            }
+            Chunk& chunk = ring[seq % window];
+            annotateChunk(chunk.first, chunk.last, chunk.text, chunk.records, chunk.matched);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                chunk.done = true;
+            }
+            chunkDone.notify_all();
+        }
+    };
+    // Also runs when starting a thread or mapping a chunk throws, so no
+    // worker is left joinable when the vector goes away.
+    auto stopWorkers = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.clear();
+            finished = true;
+        }
+        workReady.notify_all();
+        for (auto& w : workers) w.join();
+    };
+
+    AnnotateStats stats;
+    size_t submitted = 0;
+    size_t written = 0;
+    auto writeNext = [&]() {
+        Chunk& chunk = ring[written % window];
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            chunkDone.wait(lock, [&]() { return chunk.done; });
+        }
+        output.write(chunk.text.data(), static_cast<std::streamsize>(chunk.text.size()));
+        stats.records += chunk.records;
+        stats.matched += chunk.matched;
+        chunk.view = MappedFile::View();
+        chunk.text.clear();
+        chunk.records = 0;
+        chunk.matched = 0;
+        chunk.done = false;
+        ++written;
+    };
+
+    uint64_t offset = 0;
+    const uint64_t size = input.fileSize();
+    try {
+        for (unsigned t = 0; t < options.threads; ++t) workers.emplace_back(worker);
+
+        while (offset < size) {
+            if (submitted - written == window) writeNext();
+
+            size_t length = static_cast<size_t>(std::min<uint64_t>(options.chunkSize, size - offset));
+            Chunk& chunk = ring[submitted % window];
+            while (true) {
+                chunk.view = input.map(offset, length);
+                chunk.first = chunk.view.begin();
+                chunk.last = chunk.first + length;
+                if (offset + length == size) break;
+                // End the chunk after its last complete line. A chunk with no
+                // line end in it is mapped again twice as long, so a record is
+                // never split however long it is.
+                const char* p = chunk.last;
+                while (p > chunk.first && p[-1] != '\n') --p;
+                if (p > chunk.first) {
+                    chunk.last = p;
+                    break;
+                }
+                length = static_cast<size_t>(std::min<uint64_t>(static_cast<uint64_t>(length) * 2, size - offset));
+            }
+            offset += static_cast<uint64_t>(chunk.last - chunk.first);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queue.push_back(submitted++);
+            }
+            workReady.notify_one();
+        }
+        while (written < submitted) writeNext();
+    } catch (...) {
+        stopWorkers();
+        throw;
+    }
+    stopWorkers();
+
+    if (!output) throw std::runtime_error("Write to " + outputPath + " failed");
+    stats.bytes = size;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return stats;
+}
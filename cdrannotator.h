@@ -0,0 +1,43 @@
+// cdrannotator.h
+#ifndef CDRANNOTATOR_H
+#define CDRANNOTATOR_H
+
+#include "phonebook.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct AnnotateOptions {
+    size_t column = 0;          // 1-based CSV column holding the number, 0 = whole line
+    char delimiter = ',';
+    unsigned threads = 0;       // 0 = one per hardware thread
+    size_t chunkSize = 4 << 20;
+};
+
+struct AnnotateStats {
+    uint64_t records = 0;
+    uint64_t matched = 0;
+    uint64_t bytes = 0;
+    double seconds = 0;
+};
+
+// Joins a call-detail-record file against the phone book: every input line is
+// written out with the owner's name appended as one more column. The input is
+// memory-mapped one chunk at a time and chunks are annotated in parallel, but
+// at most two chunks per thread are in flight and output keeps input order, so
+// memory use does not grow with the file.
+class CdrAnnotator {
+public:
+    CdrAnnotator(const PhoneBook& book, const AnnotateOptions& options);
+
+    AnnotateStats run(const std::string& inputPath, const std::string& outputPath) const;
+
+private:
+    const PhoneBook& book;
+    AnnotateOptions options;
+
+    void annotateChunk(const char* first, const char* last, std::string& out,
+                       uint64_t& records, uint64_t& matched) const;
+};
+
+#endif
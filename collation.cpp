@@ -0,0 +1,27 @@
+// collation.cpp
+#include "collation.h"
+
+// CP1251: capitals are folded away, which frees 0xC0..0xE0 for the 33 lower
+// case Russian letters in alphabet order.
+static char weight(unsigned char c) {
+    if (c >= 'A' && c <= 'Z') return static_cast<char>(c + 0x20);
+    if (c == 0xA8 || c == 0xB8) return static_cast<char>(0xC6);   // Ё, ё
+    if (c >= 0xC0 && c <= 0xDF) c = static_cast<unsigned char>(c + 0x20);
+    if (c >= 0xE0 && c <= 0xE5) return static_cast<char>(c - 0x20);  // а..е
+    if (c >= 0xE6) return static_cast<char>(c - 0x1F);               // ж..я
+    return static_cast<char>(c);
+}
+
+std::string Collation::key(std::string_view text) {
+    std::string out;
+    appendKey(out, text);
+    return out;
+}
+
+void Collation::appendKey(std::string& out, std::string_view text) {
+    size_t start = out.size();
+    out.resize(start + text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        out[start + i] = weight(static_cast<unsigned char>(text[i]));
+    }
+}
@@ -0,0 +1,17 @@
+// collation.h
+#ifndef COLLATION_H
+#define COLLATION_H
+
+#include <string>
+#include <string_view>
+
+// Binary sort keys for names and emails. Comparing two keys as unsigned bytes
+// gives case-insensitive alphabetical order with Latin before Cyrillic and Ё
+// right after Е, so sorting never has to look at the original text again.
+class Collation {
+public:
+    static std::string key(std::string_view text);
+    static void appendKey(std::string& out, std::string_view text);
+};
+
+#endif
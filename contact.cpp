@@ -1,11 +1,18 @@
 // contact.cpp
 #include "contact.h"
 #include "validator.h"
+#include <charconv>
 #include <sstream>
 #include <algorithm>
 
+Contact::Contact(const allocator_type& alloc)
+    : lastName(alloc), emailLocal(alloc), phones(alloc), searchKey(alloc)
+{
+}
+
 Contact::Contact(const std::string& firstName, const std::string& lastName,
                  const std::string& email, const PhoneNumber& phone)
+    : Contact(allocator_type())
 {
     setFirstName(firstName);
     setLastName(lastName);
@@ -13,33 +20,68 @@ Contact::Contact(const std::string& firstName, const std::string& lastName,
     addPhone(phone);
 }
 
+Contact::Contact(const Contact& other, const allocator_type& alloc)
+    : id(other.id), firstName(other.firstName), lastName(other.lastName, alloc),
+      middleName(other.middleName), address(other.address), emailLocal(other.emailLocal, alloc),
+      emailDomain(other.emailDomain), birthDay(other.birthDay), phones(other.phones, alloc),
+      searchKey(other.searchKey, alloc)
+{
+}
+
+Contact::Contact(Contact&& other, const allocator_type& alloc)
+    : id(other.id), firstName(other.firstName), lastName(std::move(other.lastName), alloc),
+      middleName(other.middleName), address(other.address), emailLocal(std::move(other.emailLocal), alloc),
+      emailDomain(other.emailDomain), birthDay(other.birthDay), phones(std::move(other.phones), alloc),
+      searchKey(std::move(other.searchKey), alloc)
+{
+}
+
+static std::string accept(Normalized&& field, const char* error) {
+    if (!field) throw std::invalid_argument(error);
+    return std::move(field.value);
+}
+
 void Contact::setFirstName(const std::string& name) {
-    if (!Validator::validateName(name)) throw std::invalid_argument("Invalid first name");
-    firstName = Validator::trim(name);
+    firstName = StringPool::shared().intern(accept(Validator::normalizeName(name), "Invalid first name"));
+    updateSearchKey();
 }
 
 void Contact::setLastName(const std::string& name) {
-    if (!Validator::validateName(name)) throw std::invalid_argument("Invalid last name");
-    lastName = Validator::trim(name);
+    lastName = accept(Validator::normalizeName(name), "Invalid last name");
+    updateSearchKey();
 }
 
 void Contact::setMiddleName(const std::string& name) {
-    if (!name.empty() && !Validator::validateName(name)) throw std::invalid_argument("Invalid middle name");
-    middleName = Validator::trim(name);
+    Normalized middle = Validator::normalizeName(name);
+    if (middle.error == ValidationError::Empty) middle.error = ValidationError::None;
+    middleName = StringPool::shared().intern(accept(std::move(middle), "Invalid middle name"));
+    updateSearchKey();
 }
 
 void Contact::setAddress(const std::string& addr) {
-    address = Validator::trim(addr);
+    address = StringPool::shared().intern(Validator::trimmed(addr));
 }
 
 void Contact::setBirthDate(const std::string& date) {
-    if (!date.empty() && !Validator::validateDate(date)) throw std::invalid_argument("Invalid birth date");
-    birthDate = date;
+    int32_t day;
+    if (Validator::checkBirthDate(date, day) != ValidationError::None) throw std::invalid_argument("Invalid birth date");
+    birthDay = day;
 }
 
 void Contact::setEmail(const std::string& mail) {
-    if (!Validator::validateEmail(mail)) throw std::invalid_argument("Invalid email");
-    email = Validator::trim(mail);
+    assignEmail(accept(Validator::normalizeEmail(mail), "Invalid email"));
+    updateSearchKey();
+}
+
+void Contact::assignEmail(std::string_view mail) {
+    size_t at = mail.find('@');
+    emailLocal = mail.substr(0, at);
+    emailDomain = at == std::string_view::npos ? 0 : StringPool::shared().intern(mail.substr(at));
+}
+
+std::string_view Contact::getEmailDomain() const {
+    if (!emailDomain) return std::string_view();
+    return std::string_view(StringPool::shared().text(emailDomain)).substr(1);
 }
 
 void Contact::addPhone(const PhoneNumber& phone) {
@@ -51,50 +93,179 @@ void Contact::removePhone(size_t index) {
     phones.erase(phones.begin() + index);
 }
 
+void Contact::updateSearchKey() {
+    searchKey.clear();
+    Validator::appendFolded(searchKey, getFirstName());
+    searchKey += ' ';
+    Validator::appendFolded(searchKey, lastName);
+    searchKey += '\n';
+    Validator::appendFolded(searchKey, getMiddleName());
+    searchKey += '\n';
+    Validator::appendFolded(searchKey, emailLocal);
+    Validator::appendFolded(searchKey, StringPool::shared().text(emailDomain));
+}
+
 std::string Contact::toString() const {
     std::ostringstream oss;
-    oss << firstName << ";" << lastName << ";" << middleName << ";" << address << ";"
-        << birthDate << ";" << email << ";phones:";
+    oss << getFirstName() << ";" << lastName << ";" << getMiddleName() << ";" << getAddress() << ";"
+        << getBirthDate() << ";" << emailLocal << StringPool::shared().text(emailDomain) << ";phones:";
     for (const auto& p : phones) {
         oss << "(" << static_cast<int>(p.getType()) << "," << p.getNumber() << ")";
     }
     return oss.str();
 }
 
+const char* Contact::fieldName(ContactField field) {
+    switch (field) {
+    case ContactField::FirstName: return "first name";
+    case ContactField::LastName: return "last name";
+    case ContactField::MiddleName: return "middle name";
+    case ContactField::BirthDate: return "birth date";
+    case ContactField::Email: return "email";
+    case ContactField::Phone: return "phone";
+    default: return "record";
+    }
+}
+
 Contact Contact::fromString(const std::string& str) {
-    std::istringstream iss(str);
-    std::string token;
-    std::vector<std::string> fields;
-    while (std::getline(iss, token, ';')) {
-        fields.push_back(token);
+    ParseResult parsed = tryParse(str);
+    if (!parsed) {
+        if (parsed.field == ContactField::Record) throw std::invalid_argument("Invalid contact format");
+        throw std::invalid_argument(std::string("Invalid ") + fieldName(parsed.field));
+    }
+    return std::move(*parsed.contact);
+}
+
+static ParseResult reject(ContactField field, ValidationError error) {
+    ParseResult result;
+    result.field = field;
+    result.error = error;
+    return result;
+}
+
+// Splits "first;last;middle;address;birth;email;phones:(type,number)..." into
+// at most seven fields and returns how many there were.
+static size_t splitFields(std::string_view line, std::string_view (&fields)[7]) {
+    size_t count = 0;
+    for (size_t pos = 0; count < 7; ) {
+        size_t end = line.find(';', pos);
+        fields[count++] = line.substr(pos, end == std::string_view::npos ? end : end - pos);
+        if (end == std::string_view::npos) break;
+        pos = end + 1;
     }
-    if (fields.size() < 7) throw std::invalid_argument("Invalid contact format");
-
-    Contact c(fields[0], fields[1], fields[5], PhoneNumber(PhoneType::Work, "000"));
-    c.setMiddleName(fields[2]);
-    c.setAddress(fields[3]);
-    c.setBirthDate(fields[4]);
-    c.phones.clear();
-
-    std::string phonesStr = fields[6];
-    if (phonesStr.substr(0, 7) == "phones:") {
-        phonesStr = phonesStr.substr(7);
-        size_t pos = 0;
-        while (pos < phonesStr.size()) {
-            if (phonesStr[pos] != '(') { pos++; continue; }
-            size_t end = phonesStr.find(')', pos);
-            if (end == std::string::npos) break;
-            std::string pair = phonesStr.substr(pos + 1, end - pos - 1);
-            size_t comma = pair.find(',');
-            if (comma != std::string::npos) {
-                try {
-                    int type = std::stoi(pair.substr(0, comma));
-                    std::string num = pair.substr(comma + 1);
-                    c.addPhone(PhoneNumber(static_cast<PhoneType>(type), num));
-                } catch (...) {}
-            }
-            pos = end + 1;
+    return count;
+}
+
+// Reads "phones:(type,number)...". A pair that does not parse or has no valid
+// key is skipped in every load mode; returns how many were. Saved numbers look
+// like "8 (916) 123-45-67", so a pair ends at the ')' before the next pair,
+// not at the first one.
+static size_t parsePhones(std::string_view field, std::pmr::vector<PhoneNumber>& phones) {
+    size_t skipped = 0;
+    if (field.substr(0, 7) != "phones:") return skipped;
+    field.remove_prefix(7);
+    size_t pos = 0;
+    while (pos < field.size()) {
+        if (field[pos] != '(') { pos++; continue; }
+        size_t end = field.find(")(", pos);
+        if (end == std::string_view::npos) end = field.rfind(')');
+        if (end == std::string_view::npos || end < pos) break;
+        std::string_view pair = field.substr(pos + 1, end - pos - 1);
+        pos = end + 1;
+
+        size_t comma = pair.find(',');
+        int type = -1;
+        if (comma == std::string_view::npos ||
+            std::from_chars(pair.data(), pair.data() + comma, type).ptr != pair.data() + comma ||
+            type < 0 || type > static_cast<int>(PhoneType::Office)) {
+            ++skipped;
+            continue;
         }
+        PhoneNumber phone = PhoneNumber::trusted(static_cast<PhoneType>(type), pair.substr(comma + 1));
+        if (phone.getKey() == 0) ++skipped;
+        else phones.push_back(phone);
+    }
+    return skipped;
+}
+
+// Validates a line without throwing. Bad phones are skipped, as before.
+ParseResult Contact::tryParse(std::string_view line, const allocator_type& alloc) {
+    std::string_view fields[7];
+    if (splitFields(line, fields) < 7) return reject(ContactField::Record, ValidationError::MissingField);
+
+    ContactFields parsed(alloc);
+    Normalized first = Validator::normalizeName(fields[0]);
+    if (!first) return reject(ContactField::FirstName, first.error);
+    Normalized last = Validator::normalizeName(fields[1]);
+    if (!last) return reject(ContactField::LastName, last.error);
+    Normalized middle = Validator::normalizeName(fields[2]);
+    if (!middle && middle.error != ValidationError::Empty) return reject(ContactField::MiddleName, middle.error);
+    ValidationError dateError = Validator::checkBirthDate(fields[4], parsed.birthDay);
+    if (dateError != ValidationError::None) return reject(ContactField::BirthDate, dateError);
+    Normalized mail = Validator::normalizeEmail(fields[5]);
+    if (!mail) return reject(ContactField::Email, mail.error);
+
+    parsed.firstName = first.value;
+    parsed.lastName = last.value;
+    parsed.middleName = middle.value;
+    parsed.address = Validator::trimmed(fields[3]);
+    parsed.email = mail.value;
+    size_t skipped = parsePhones(fields[6], parsed.phones);
+
+    ParseResult result;
+    result.contact = trusted(std::move(parsed));
+    result.skippedPhones = skipped;
+    return result;
+}
+
+ParseResult Contact::parseTrusted(std::string_view line, const allocator_type& alloc) {
+    std::string_view fields[7];
+    if (splitFields(line, fields) < 7) return reject(ContactField::Record, ValidationError::MissingField);
+
+    ContactFields parsed(alloc);
+    parsed.firstName = fields[0];
+    parsed.lastName = fields[1];
+    parsed.middleName = fields[2];
+    parsed.address = fields[3];
+    if (!fields[4].empty()) {
+        parsed.birthDay = BirthDate::parse(fields[4]);
+        if (parsed.birthDay == BirthDate::none) return reject(ContactField::BirthDate, ValidationError::BadDate);
     }
+    parsed.email = fields[5];
+    size_t skipped = parsePhones(fields[6], parsed.phones);
+
+    ParseResult result;
+    result.contact = trusted(std::move(parsed));
+    result.skippedPhones = skipped;
+    return result;
+}
+
+Contact Contact::trusted(ContactFields&& fields) {
+    StringPool& pool = StringPool::shared();
+    Contact c(fields.lastName.get_allocator());
+    c.firstName = pool.intern(fields.firstName);
+    c.lastName = std::move(fields.lastName);
+    c.middleName = pool.intern(fields.middleName);
+    c.address = pool.intern(fields.address);
+    c.assignEmail(fields.email);
+    c.birthDay = fields.birthDay;
+    c.phones = std::move(fields.phones);
+    c.updateSearchKey();
     return c;
-}
\ No newline at end of file
+}
+
+ValidationError Contact::verify(ContactField& field) const {
+    ValidationError error = Validator::checkName(getFirstName());
+    if (error != ValidationError::None) { field = ContactField::FirstName; return error; }
+    error = Validator::checkName(lastName);
+    if (error != ValidationError::None) { field = ContactField::LastName; return error; }
+    error = Validator::checkName(getMiddleName());
+    if (error != ValidationError::None && error != ValidationError::Empty) { field = ContactField::MiddleName; return error; }
+    if (birthDay != BirthDate::none && !Validator::validateBirthDay(birthDay)) {
+        field = ContactField::BirthDate;
+        return ValidationError::BadDate;
+    }
+    error = Validator::checkEmail(emailLocal, StringPool::shared().text(emailDomain));
+    if (error != ValidationError::None) { field = ContactField::Email; return error; }
+    return ValidationError::None;
+}
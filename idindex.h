@@ -0,0 +1,39 @@
+// idindex.h
+#ifndef IDINDEX_H
+#define IDINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Open-addressing hash table from contact id to its slot in PhoneBook::contacts.
+// Linear probing with backward-shift deletion, so there are no tombstones.
+// Id 0 marks an empty bucket and is never handed out.
+class IdIndex {
+public:
+    static const size_t npos = static_cast<size_t>(-1);
+
+    IdIndex();
+
+    void insert(uint64_t id, size_t slot);
+    size_t find(uint64_t id) const;
+    bool erase(uint64_t id);
+    void clear();
+    void reserve(size_t n);
+    size_t size() const { return count; }
+
+private:
+    struct Bucket {
+        uint64_t id;
+        size_t slot;
+    };
+
+    std::vector<Bucket> buckets;
+    size_t count;
+    size_t mask;
+
+    static uint64_t hash(uint64_t id);
+    void rehash(size_t newCapacity);
+};
+
+#endif
@@ -1,16 +1,27 @@
 // main.cpp
 #include "phonebook.h"
+#include "cdrannotator.h"
 #include <iostream>
 #include <sstream>
 #include <windows.h>
 #include "validator.h"
 #include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
 
 void clearInput() {
     std::cin.clear();
     std::cin.ignore(10000, '\n');
 }
 
+// A command-line argument that must be a whole unsigned number.
+bool parseNumber(const char* text, size_t& value) {
+    const char* end = text + std::strlen(text);
+    auto result = std::from_chars(text, end, value);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
 Contact createContact() {
     std::string fn, ln, em;
     std::cout << "First Name: "; std::getline(std::cin, fn);
@@ -38,11 +49,12 @@ Contact createContact() {
     } while (true);
 }
 
-void printContact(const Contact& c, size_t i) {
-    std::cout << "=== " << i << " ===\n";
+void printContact(const Contact& c) {
+    std::cout << "=== " << c.getId() << " ===\n";
     std::cout << c.getFirstName() << " " << c.getLastName();
     if (!c.getMiddleName().empty()) std::cout << " " << c.getMiddleName();
     std::cout << "\nEmail: " << c.getEmail() << "\n";
+    if (c.getBirthDay() != BirthDate::none) std::cout << "Born: " << c.getBirthDate() << "\n";
     for (size_t j = 0; j < c.getPhones().size(); ++j) {
         std::string t = (c.getPhones()[j].getType() == PhoneType::Work) ? "Work" :
                         (c.getPhones()[j].getType() == PhoneType::Home) ? "Home" : "Office";
@@ -51,16 +63,97 @@ void printContact(const Contact& c, size_t i) {
     std::cout << std::endl;
 }
 
-int main() {
+void annotate(const PhoneBook& book, const std::string& input, const std::string& output,
+              const AnnotateOptions& options) {
+    try {
+        AnnotateStats stats = CdrAnnotator(book, options).run(input, output);
+        double seconds = stats.seconds > 0 ? stats.seconds : 1e-9;
+        std::cout << "Annotated " << stats.records << " records (" << stats.matched << " matched) in "
+                  << stats.seconds << " s: " << static_cast<uint64_t>(stats.records / seconds)
+                  << " records/s, " << stats.bytes / seconds / (1 << 20) << " MB/s\n";
+    } catch (const std::exception& e) {
+        std::cout << "Annotate failed: " << e.what() << "\n";
+    }
+}
+
+// Contacts per operator, busiest first. The plan is read from planFile the
+// first time, or again when a file is named.
+void operatorReport(const PhoneBook& book, const std::string& planFile, bool reload) {
+    NumberingPlan& plan = NumberingPlan::shared();
+    if (reload || plan.size() == 0) {
+        try {
+            size_t ranges = plan.loadFromFile(planFile);
+            std::cout << "Numbering plan: " << ranges << " ranges, " << plan.operatorCount() << " operators\n";
+        } catch (const std::exception& e) {
+            std::cout << "Report failed: " << e.what() << "\n";
+            return;
+        }
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    std::vector<size_t> counts = book.contactsPerOperator(plan);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    std::vector<uint32_t> ids;
+    for (uint32_t id = 1; id < counts.size(); ++id) {
+        if (counts[id] != 0) ids.push_back(id);
+    }
+    std::sort(ids.begin(), ids.end(), [&counts](uint32_t a, uint32_t b) {
+        return counts[a] != counts[b] ? counts[a] > counts[b] : a < b;
+    });
+    for (uint32_t id : ids) std::cout << counts[id] << "\t" << plan.operatorName(id) << "\n";
+    std::cout << counts[0] << "\tno known operator\n";
+    std::cout << book.getContacts().size() << " contacts in " << seconds << " s\n";
+}
+
+void printLoadStats(const LoadStats& stats) {
+    std::cout << "Loaded " << stats.accepted << " of " << stats.rowsRead << " rows\n";
+    for (const auto& r : stats.rejected) {
+        std::cout << "  rejected " << r.second << ": " << Contact::fieldName(r.first.first) << ", "
+                  << Validator::errorName(r.first.second) << "\n";
+    }
+    if (stats.phonesSkipped) std::cout << "  skipped " << stats.phonesSkipped << " bad phones\n";
+}
+
+int main(int argc, char* argv[]) {
     SetConsoleCP(1251);
     SetConsoleOutputCP(1251);
 
     PhoneBook book;
-    book.loadFromFile("phonebook.txt");
+    // phonebook.txt is our own snapshot, so it is loaded without revalidation
+    // unless --verify asks for every field to be checked again.
+    LoadMode mode = LoadMode::Trusted;
+    if (argc >= 2 && std::string(argv[1]) == "--verify") {
+        mode = LoadMode::Verify;
+        --argc;
+        ++argv;
+    }
+    LoadStats loaded = book.loadFromFile("phonebook.txt", mode);
+    if (loaded.accepted < loaded.rowsRead || loaded.phonesSkipped) printLoadStats(loaded);
+
+    // phonebook [--verify] annotate <input> <output> [column] [threads]
+    if (argc >= 4 && std::string(argv[1]) == "annotate") {
+        AnnotateOptions options;
+        size_t threads = 0;
+        if ((argc >= 5 && !parseNumber(argv[4], options.column)) ||
+            (argc >= 6 && (!parseNumber(argv[5], threads) || threads > 1024))) {
+            std::cout << "Usage: phonebook [--verify] annotate <input> <output> [column] [threads]\n";
+            return 1;
+        }
+        options.threads = static_cast<unsigned>(threads);
+        annotate(book, argv[2], argv[3], options);
+        return 0;
+    }
+
+    // phonebook [--verify] operators <plan.csv>
+    if (argc >= 3 && std::string(argv[1]) == "operators") {
+        operatorReport(book, argv[2], true);
+        return 0;
+    }
 
     std::string line;
     while (true) {
-        std::cout << "\n> add | remove <id> | edit <id> | search <q> | sort <field> | list | exit\n> ";
+        std::cout << "\n> add | remove <id> | edit <id> | search <q> | phone <number> | annotate <in> <out> [column] | operators [plan.csv] | sort <field,...> | birthdays [days] | born <from> <to> | list [offset] [count] | exit\n> ";
         if (!std::getline(std::cin, line)) break;
 
         std::istringstream ss(line);
@@ -70,8 +163,15 @@ int main() {
         if (cmd == "exit") break;
 
         else if (cmd == "list") {
-            for (size_t i = 0; i < book.getContacts().size(); ++i) {
-                printContact(book.getContacts()[i], i);
+            size_t offset = 0, count = 0;
+            if (ss >> offset) {
+                if (!(ss >> count)) count = 20;
+                for (uint64_t id : book.currentRange(offset, count)) printContact(book.getContact(id));
+            } else {
+                book.forEachContact([](const Contact& c) {
+                    printContact(c);
+                    return true;
+                });
             }
         }
 
@@ -84,8 +184,8 @@ int main() {
         }
 
         else if (cmd == "remove") {
-            size_t id;
-            if (ss >> id && id < book.getContacts().size()) {
+            uint64_t id;
+            if (ss >> id && book.hasContact(id)) {
                 book.removeContact(id);
                 std::cout << "Removed.\n";
             } else {
@@ -94,8 +194,8 @@ int main() {
         }
 
         else if (cmd == "edit") {
-            size_t id;
-            if (ss >> id && id < book.getContacts().size()) {
+            uint64_t id;
+            if (ss >> id && book.hasContact(id)) {
                 clearInput();
                 try {
                     book.editContact(id, createContact());
@@ -113,17 +213,68 @@ int main() {
             if (query.empty()) {
                 std::cout << "Enter search text.\n";
             } else {
-                auto results = book.search(query);
-                if (results.empty()) {
+                size_t found = 0;
+                book.forEachMatch(query, [&found](const Contact& c, const SearchHit&) {
+                    printContact(c);
+                    ++found;
+                    return true;
+                });
+                if (found == 0) {
                     std::cout << "No results.\n";
-                } else {
-                    for (size_t i = 0; i < results.size(); ++i) {
-                        printContact(results[i], i);
-                    }
                 }
             }
         }
 
+        else if (cmd == "phone") {
+            std::string number;
+            std::getline(ss, number);
+            std::vector<uint64_t> ids = book.findAllByPhone(number);
+            if (ids.empty()) {
+                std::cout << "No contact with this number.\n";
+            }
+            for (uint64_t id : ids) {
+                printContact(book.getContact(id));
+            }
+        }
+
+        else if (cmd == "birthdays") {
+            int days = 7;
+            ss >> days;
+            std::vector<uint64_t> ids = book.upcomingBirthdays(days);
+            if (ids.empty()) std::cout << "No birthdays in the next " << days << " days.\n";
+            for (uint64_t id : ids) printContact(book.getContact(id));
+        }
+
+        else if (cmd == "born") {
+            std::string from, to;
+            ss >> from >> to;
+            int32_t first = BirthDate::parse(from);
+            int32_t last = BirthDate::parse(to);
+            if (first == BirthDate::none || last == BirthDate::none) {
+                std::cout << "Usage: born <YYYY-MM-DD> <YYYY-MM-DD>\n";
+            } else {
+                std::vector<uint64_t> ids = book.bornBetween(first, last);
+                if (ids.empty()) std::cout << "Nobody was born in this period.\n";
+                for (uint64_t id : ids) printContact(book.getContact(id));
+            }
+        }
+
+        else if (cmd == "annotate") {
+            std::string input, output, column;
+            AnnotateOptions options;
+            if (ss >> input >> output && (!(ss >> column) || parseNumber(column.c_str(), options.column))) {
+                annotate(book, input, output, options);
+            } else {
+                std::cout << "Usage: annotate <input> <output> [column]\n";
+            }
+        }
+
+        else if (cmd == "operators") {
+            std::string planFile;
+            bool reload = static_cast<bool>(ss >> planFile);
+            operatorReport(book, reload ? planFile : "numbering_plan.csv", reload);
+        }
+
         else if (cmd == "sort") {
             std::string field;
             size_t pos = line.find("sort");
@@ -132,17 +283,18 @@ int main() {
             }
             field = Validator::trim(field);
             if (field.empty()) {
-                std::cout << "Enter field: name, last, email\n";
+                std::cout << "Enter fields: name, last, middle, email, birthdate (e.g. last,first,-birthdate)\n";
             } else {
                 if (book.sortByField(field)) {
                     std::string field_lower = field;
                     std::transform(field_lower.begin(), field_lower.end(), field_lower.begin(), ::tolower);
                     std::cout << "Sorted by '" << field_lower << "'.\n";
-                    for (size_t i = 0; i < book.getContacts().size(); ++i) {
-                        printContact(book.getContacts()[i], i);
-                    }
+                    book.forEachContact([](const Contact& c) {
+                        printContact(c);
+                        return true;
+                    });
                 } else {
-                    std::cout << "Unknown field. Use: name, last, email\n";
+                    std::cout << "Unknown field. Use: name, last, middle, email, birthdate; '-' reverses a field\n";
                 }
             }
         }
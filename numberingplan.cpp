@@ -0,0 +1,148 @@
+// numberingplan.cpp
+#include "numberingplan.h"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+struct PlanRow {
+    uint32_t code;
+    uint32_t first;
+    uint32_t last;
+    uint32_t owner;
+};
+
+static std::string_view trimmed(std::string_view s) {
+    size_t start = s.find_first_not_of(" \t");
+    if (start == std::string_view::npos) return std::string_view();
+    return s.substr(start, s.find_last_not_of(" \t") - start + 1);
+}
+
+// Splits one CSV line. A field may be quoted, with "" for a quote inside.
+static void splitCsv(std::string_view line, char delimiter, std::vector<std::string>& fields) {
+    fields.clear();
+    std::string field;
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (quoted) {
+            if (c != '"') field += c;
+            else if (i + 1 < line.size() && line[i + 1] == '"') field += line[++i];
+            else quoted = false;
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == delimiter) {
+            fields.push_back(std::move(field));
+            field.clear();
+        } else {
+            field += c;
+        }
+    }
+    fields.push_back(std::move(field));
+}
+
+static bool parseNumber(std::string_view text, uint32_t& value) {
+    text = trimmed(text);
+    const char* end = text.data() + text.size();
+    auto result = std::from_chars(text.data(), end, value);
+    return !text.empty() && result.ec == std::errc() && result.ptr == end;
+}
+
+static uint32_t intern(std::string_view name, std::vector<std::string>& names,
+                       std::unordered_map<std::string, uint32_t>& ids) {
+    auto it = ids.emplace(std::string(name), static_cast<uint32_t>(names.size()));
+    if (it.second) names.emplace_back(name);
+    return it.first->second;
+}
+
+size_t NumberingPlan::loadFromFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) throw std::runtime_error("Cannot open " + filename);
+    clear();
+
+    std::unordered_map<std::string, uint32_t> operatorIndex, regionIndex;
+    // A range with no operator name gets id 0, the same as no range at all,
+    // rather than a bucket of its own.
+    operatorIndex.emplace(std::string(), 0);
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> ownerIndex;
+    std::vector<PlanRow> rows;
+    std::vector<std::string> fields;
+    std::string line;
+    char delimiter = 0;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        if (!delimiter) delimiter = line.find(';') != std::string::npos ? ';' : ',';
+
+        splitCsv(line, delimiter, fields);
+        uint32_t code, first, last;
+        if (fields.size() < 6 || !parseNumber(fields[0], code) || !parseNumber(fields[1], first) ||
+            !parseNumber(fields[2], last) || code >= codeCount || first > last || last > 9999999) continue;
+
+        uint32_t op = intern(trimmed(fields[4]), operators, operatorIndex);
+        uint32_t region = intern(trimmed(fields[5]), regions, regionIndex);
+        auto owner = ownerIndex.emplace(std::make_pair(op, region), static_cast<uint32_t>(operatorIds.size()));
+        if (owner.second) {
+            operatorIds.push_back(op);
+            regionIds.push_back(region);
+        }
+        rows.push_back(PlanRow{code, first, last, owner.first->second});
+    }
+
+    std::sort(rows.begin(), rows.end(), [](const PlanRow& a, const PlanRow& b) {
+        return a.code != b.code ? a.code < b.code : a.first < b.first;
+    });
+    buckets.assign(codeCount + 1, 0);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const PlanRow& row = rows[i];
+        if (i > 0 && rows[i - 1].code == row.code && owners.back() == row.owner && lasts.back() + 1 == row.first) {
+            lasts.back() = row.last;
+            continue;
+        }
+        firsts.push_back(row.first);
+        lasts.push_back(row.last);
+        owners.push_back(row.owner);
+        ++buckets[row.code + 1];
+    }
+    for (uint32_t c = 1; c <= codeCount; ++c) buckets[c] += buckets[c - 1];
+    return rows.size();
+}
+
+void NumberingPlan::clear() {
+    buckets.clear();
+    firsts.clear();
+    lasts.clear();
+    owners.clear();
+    operatorIds.clear();
+    regionIds.clear();
+    operators.assign(1, std::string());
+    regions.clear();
+}
+
+PhoneRegion NumberingPlan::find(uint64_t key) const {
+    if (buckets.empty() || key / 10000000000ULL != 7) return PhoneRegion();
+    uint32_t code = static_cast<uint32_t>(key / 10000000 % 1000);
+    uint32_t subscriber = static_cast<uint32_t>(key % 10000000);
+
+    size_t n = buckets[code + 1] - buckets[code];
+    if (n == 0) return PhoneRegion();
+    const uint32_t* base = firsts.data() + buckets[code];
+    while (n > 1) {
+        size_t half = n / 2;
+        base = base[half] <= subscriber ? base + half : base;
+        n -= half;
+    }
+    size_t i = static_cast<size_t>(base - firsts.data());
+    if (*base > subscriber || lasts[i] < subscriber) return PhoneRegion();
+
+    uint32_t owner = owners[i];
+    return PhoneRegion{operatorIds[owner], operators[operatorIds[owner]], regions[regionIds[owner]]};
+}
+
+NumberingPlan& NumberingPlan::shared() {
+    static NumberingPlan plan;
+    return plan;
+}
@@ -0,0 +1,58 @@
+// numberingplan.h
+#ifndef NUMBERINGPLAN_H
+#define NUMBERINGPLAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Who serves a number. operatorId is 0 when the plan has no range for it or
+// the range names no operator.
+struct PhoneRegion {
+    uint32_t operatorId = 0;
+    std::string_view operatorName;
+    std::string_view region;
+
+    explicit operator bool() const { return operatorId != 0; }
+};
+
+// Operator and region of Russian numbers, from the ABC/DEF ranges of the
+// national numbering plan. Ranges are kept per three-digit code, sorted by
+// their first seven-digit subscriber number; neighbours with the same owner
+// are merged and operator and region names are stored once. A lookup is one
+// bucket step and a branch-free binary search inside the bucket.
+class NumberingPlan {
+public:
+    // Replaces the ranges with those of a numbering-plan CSV: code, first,
+    // last, capacity, operator, region, separated by ';' or ','. Lines that
+    // do not parse, like the header, are skipped. Returns the ranges read.
+    size_t loadFromFile(const std::string& filename);
+    void clear();
+
+    // By Validator::phoneKey; numbers outside +7 are never found.
+    PhoneRegion find(uint64_t key) const;
+    size_t size() const { return firsts.size(); }
+    // Operator ids run from 1 to operatorCount().
+    size_t operatorCount() const { return operators.size() - 1; }
+    const std::string& operatorName(uint32_t id) const { return operators[id]; }
+
+    // The plan PhoneNumber::region() reads. Load it before the lookups
+    // start; lookups do not lock.
+    static NumberingPlan& shared();
+
+private:
+    static const uint32_t codeCount = 1000;
+
+    std::vector<uint32_t> buckets;      // ranges of code c: [buckets[c], buckets[c + 1])
+    std::vector<uint32_t> firsts;
+    std::vector<uint32_t> lasts;
+    std::vector<uint32_t> owners;       // index into operatorIds and regionIds
+    std::vector<uint32_t> operatorIds;
+    std::vector<uint32_t> regionIds;
+    std::vector<std::string> operators{std::string()};
+    std::vector<std::string> regions;
+};
+
+#endif
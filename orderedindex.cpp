@@ -0,0 +1,178 @@
+// orderedindex.cpp
+#include "orderedindex.h"
+#include "parallelsort.h"
+#include <algorithm>
+
+uint64_t OrderedIndex::prefixOf(const std::string& key) {
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        prefix <<= 8;
+        if (i < key.size()) prefix |= static_cast<unsigned char>(key[i]);
+    }
+    return prefix;
+}
+
+bool OrderedIndex::less(const Entry& e, uint64_t prefix, const std::string& key, uint64_t id) {
+    if (e.prefix != prefix) return e.prefix < prefix;
+    int c = e.key.size() <= 8 && key.size() <= 8
+        ? static_cast<int>(e.key.size()) - static_cast<int>(key.size())
+        : e.key.compare(key);
+    return c < 0 || (c == 0 && e.id < id);
+}
+
+size_t OrderedIndex::findBlock(uint64_t prefix, const std::string& key, uint64_t id) const {
+    size_t lo = 0;
+    size_t hi = blocks.size();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (less(blocks[mid].back(), prefix, key, id)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+void OrderedIndex::insert(const std::string& key, uint64_t id) {
+    uint64_t prefix = prefixOf(key);
+    if (blocks.empty()) {
+        blocks.emplace_back(1, Entry{prefix, key, id});
+        count = 1;
+        rebuildTree();
+        return;
+    }
+    size_t b = std::min(findBlock(prefix, key, id), blocks.size() - 1);
+    auto& block = blocks[b];
+    auto pos = std::lower_bound(block.begin(), block.end(), key,
+        [prefix, id](const Entry& e, const std::string& k) { return less(e, prefix, k, id); });
+    block.insert(pos, Entry{prefix, key, id});
+    ++count;
+
+    if (block.size() > maxBlock) {
+        std::vector<Entry> upper(std::make_move_iterator(block.begin() + maxBlock / 2),
+                                 std::make_move_iterator(block.end()));
+        block.erase(block.begin() + maxBlock / 2, block.end());
+        blocks.insert(blocks.begin() + b + 1, std::move(upper));
+        rebuildTree();
+    } else {
+        addToTree(b, 1, false);
+    }
+}
+
+bool OrderedIndex::erase(const std::string& key, uint64_t id) {
+    uint64_t prefix = prefixOf(key);
+    size_t b = findBlock(prefix, key, id);
+    if (b == blocks.size()) return false;
+
+    auto& block = blocks[b];
+    auto pos = std::lower_bound(block.begin(), block.end(), key,
+        [prefix, id](const Entry& e, const std::string& k) { return less(e, prefix, k, id); });
+    if (pos == block.end() || pos->id != id || pos->key != key) return false;
+
+    block.erase(pos);
+    --count;
+    if (block.empty()) {
+        blocks.erase(blocks.begin() + b);
+        rebuildTree();
+    } else {
+        addToTree(b, 1, true);
+    }
+    return true;
+}
+
+void OrderedIndex::assign(std::vector<std::string> keys, const std::vector<uint64_t>& ids) {
+    // Sort 16-byte (prefix, position) pairs rather than whole entries; ties on
+    // the prefix fall back to the key, then to the id.
+    std::vector<SortItem> items(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) items[i] = SortItem{prefixOf(keys[i]), i};
+    ParallelSort::sort(items, [&](size_t a, size_t b) {
+        const std::string& x = keys[a];
+        const std::string& y = keys[b];
+        if (x.size() > 8 || y.size() > 8) {
+            int c = x.compare(y);
+            if (c != 0) return c < 0;
+        } else if (x.size() != y.size()) {
+            return x.size() < y.size();
+        }
+        return ids[a] < ids[b];
+    });
+    fill(items, keys, ids);
+}
+
+void OrderedIndex::assignRanked(std::vector<std::string> keys, const std::vector<uint64_t>& ids,
+                                const std::vector<uint32_t>& ranks) {
+    // Whole keys are never compared: the radix passes only see the rank.
+    std::vector<SortItem> items(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) items[i] = SortItem{ranks[i], i};
+    ParallelSort::sort(items, [&](size_t a, size_t b) { return ids[a] < ids[b]; });
+    for (auto& item : items) item.prefix = prefixOf(keys[item.pos]);
+    fill(items, keys, ids);
+}
+
+// Cuts items, already in order and carrying their key prefixes, into half-full
+// blocks.
+void OrderedIndex::fill(const std::vector<SortItem>& items, std::vector<std::string>& keys,
+                        const std::vector<uint64_t>& ids) {
+    blocks.clear();
+    for (size_t i = 0; i < items.size(); i += maxBlock / 2) {
+        size_t end = std::min(items.size(), i + maxBlock / 2);
+        std::vector<Entry> block;
+        block.reserve(end - i);
+        for (size_t j = i; j < end; ++j) {
+            block.push_back(Entry{items[j].prefix, std::move(keys[items[j].pos]), ids[items[j].pos]});
+        }
+        blocks.push_back(std::move(block));
+    }
+    count = items.size();
+    rebuildTree();
+}
+
+void OrderedIndex::clear() {
+    blocks.clear();
+    tree.clear();
+    count = 0;
+}
+
+size_t OrderedIndex::lowerBound(const std::string& key) const {
+    uint64_t prefix = prefixOf(key);
+    size_t b = findBlock(prefix, key, 0);
+    if (b == blocks.size()) return count;
+    auto pos = std::lower_bound(blocks[b].begin(), blocks[b].end(), key,
+        [prefix](const Entry& e, const std::string& k) { return less(e, prefix, k, 0); });
+    return entriesBefore(b) + static_cast<size_t>(pos - blocks[b].begin());
+}
+
+size_t OrderedIndex::locate(size_t rank, size_t& offset) const {
+    // Largest prefix of blocks holding at most `rank` entries.
+    size_t pos = 0;
+    size_t step = 1;
+    while (step * 2 < tree.size()) step *= 2;
+    for (; step > 0; step /= 2) {
+        if (pos + step < tree.size() && tree[pos + step] <= rank) {
+            pos += step;
+            rank -= tree[pos];
+        }
+    }
+    offset = rank;
+    return pos;
+}
+
+size_t OrderedIndex::entriesBefore(size_t block) const {
+    size_t sum = 0;
+    for (size_t i = block; i > 0; i -= i & (~i + 1)) sum += tree[i];
+    return sum;
+}
+
+void OrderedIndex::addToTree(size_t block, size_t delta, bool subtract) {
+    for (size_t i = block + 1; i < tree.size(); i += i & (~i + 1)) {
+        if (subtract) tree[i] -= delta;
+        else tree[i] += delta;
+    }
+}
+
+void OrderedIndex::rebuildTree() {
+    tree.assign(blocks.size() + 1, 0);
+    for (size_t i = 1; i < tree.size(); ++i) {
+        tree[i] += blocks[i - 1].size();
+        size_t parent = i + (i & (~i + 1));
+        if (parent < tree.size()) tree[parent] += tree[i];
+    }
+}
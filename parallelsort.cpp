@@ -0,0 +1,61 @@
+// parallelsort.cpp
+#include "parallelsort.h"
+#include <array>
+
+bool ParallelSort::partition(SortItem* first, SortItem* last, SortItem* buffer,
+                             unsigned shift, size_t* bounds, TaskPool& pool) {
+    size_t n = static_cast<size_t>(last - first);
+    size_t chunks = std::max<size_t>(1, std::min<size_t>(pool.size(), n / serialCutoff));
+    std::vector<std::array<size_t, 256>> counts(chunks);
+
+    TaskPool::Group counting;
+    for (size_t c = 0; c < chunks; ++c) {
+        pool.run(counting, [&, c]() {
+            auto& count = counts[c];
+            count.fill(0);
+            for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i) {
+                ++count[(first[i].prefix >> shift) & 0xFF];
+            }
+        });
+    }
+    pool.wait(counting);
+
+    // Turn the counts into the first output slot of every (chunk, bucket).
+    size_t total = 0;
+    for (size_t b = 0; b < 256; ++b) {
+        bounds[b] = total;
+        for (size_t c = 0; c < chunks; ++c) {
+            size_t k = counts[c][b];
+            counts[c][b] = total;
+            total += k;
+        }
+        if (total - bounds[b] == n) return false;
+    }
+    bounds[256] = total;
+
+    TaskPool::Group scattering;
+    for (size_t c = 0; c < chunks; ++c) {
+        pool.run(scattering, [&, c]() {
+            auto& next = counts[c];
+            for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i) {
+                buffer[next[(first[i].prefix >> shift) & 0xFF]++] = first[i];
+            }
+        });
+    }
+    pool.wait(scattering);
+    copy(buffer, buffer + n, first, pool);
+    return true;
+}
+
+void ParallelSort::copy(const SortItem* first, const SortItem* last, SortItem* out, TaskPool& pool) {
+    size_t n = static_cast<size_t>(last - first);
+    size_t chunks = std::max<size_t>(1, std::min<size_t>(pool.size(), n / serialCutoff));
+    TaskPool::Group copying;
+    for (size_t c = 1; c < chunks; ++c) {
+        pool.run(copying, [=]() {
+            std::copy(first + n * c / chunks, first + n * (c + 1) / chunks, out + n * c / chunks);
+        });
+    }
+    std::copy(first, first + n / chunks, out);
+    pool.wait(copying);
+}
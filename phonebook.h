@@ -3,21 +3,161 @@
 #define PHONEBOOK_H
 
 #include "contact.h"
+#include "idindex.h"
+#include "trigramindex.h"
+#include "searchkeybuffer.h"
+#include "phoneindex.h"
+#include "orderedindex.h"
+#include "validator.h"
+#include "numberingplan.h"
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <utility>
 #include <vector>
 
+// A search match: the contact id and where the query starts in the
+// contact's getSearchKey(), for highlighting.
+struct SearchHit {
+    uint64_t id;
+    size_t offset;
+};
+
+// What loadFromFile made of a file. Empty lines are not rows; rejected rows
+// are counted by the field that failed and why. A bad phone does not reject
+// its row in any mode; it is dropped and counted in phonesSkipped.
+struct LoadStats {
+    size_t rowsRead = 0;
+    size_t accepted = 0;
+    size_t phonesSkipped = 0;
+    std::map<std::pair<ContactField, ValidationError>, size_t> rejected;
+};
+
+// How loadFromFile treats each line. Validate checks every field; Trusted
+// takes lines our own saveToFile wrote as they are; Verify loads as Trusted
+// and then checks all fields in parallel, dropping the bad rows.
+enum class LoadMode { Validate, Trusted, Verify };
+
+enum class SortField { FirstName, LastName, MiddleName, Email, BirthDate };
+
+// One level of a multi-key ordering.
+struct OrderKey {
+    SortField field;
+    bool descending;
+};
+
 class PhoneBook {
 public:
-    void addContact(const Contact& contact);
-    void removeContact(size_t index);
-    void editContact(size_t index, const Contact& newContact);
-    std::vector<Contact> search(const std::string& query) const;
-    bool sortByField(const std::string& field);
+    uint64_t addContact(const Contact& contact);
+    void removeContact(uint64_t id);
+    void editContact(uint64_t id, const Contact& newContact);
+    bool hasContact(uint64_t id) const { return index.find(id) != IdIndex::npos; }
+    const Contact& getContact(uint64_t id) const;
+    std::vector<SearchHit> search(const std::string& query, size_t offset = 0,
+                                  size_t limit = static_cast<size_t>(-1)) const;
+    // Calls onHit(contact, hit) for each match until it returns false.
+    template <typename Callback>
+    void forEachMatch(const std::string& query, Callback onHit) const;
+    // Exact caller-ID lookup; the number may be written in any format.
+    const Contact* findByPhone(const std::string& number) const;
+    std::vector<uint64_t> findAllByPhone(const std::string& number) const;
+    const Contact* findByPhoneKey(uint64_t key) const;
+    // Contacts per operator id of the plan, each contact counted once for
+    // every operator among its phones; [0] counts contacts with none.
+    std::vector<size_t> contactsPerOperator(const NumberingPlan& plan) const;
+    // Picks the order forEachContact() uses; contacts are never moved. The
+    // spec lists fields by priority, "-" reverses one: "last,first,-birthdate".
+    bool sortByField(const std::string& spec);
+    bool sortBy(const std::vector<OrderKey>& keys);
+    static bool parseSortField(const std::string& name, SortField& field);
+    static bool parseOrder(const std::string& spec, std::vector<OrderKey>& keys);
+    // Ids of rows [offset, offset + count) in the given order. An order with
+    // no maintained index is answered by partial selection, without sorting
+    // the whole book.
+    std::vector<uint64_t> orderedRange(SortField field, size_t offset, size_t count) const;
+    std::vector<uint64_t> orderedRange(const std::vector<OrderKey>& keys, size_t offset, size_t count) const;
+    // Ids of rows [offset, offset + count) in the order forEachContact() uses.
+    std::vector<uint64_t> currentRange(size_t offset, size_t count) const;
+    // Ids of contacts whose birthday falls on one of the `days` days starting
+    // at `from`, soonest first.
+    std::vector<uint64_t> upcomingBirthdays(int days, int32_t from = BirthDate::today()) const;
+    // Ids of contacts born in [from, to], oldest first.
+    std::vector<uint64_t> bornBetween(int32_t from, int32_t to) const;
+    // Calls fn(contact) in the current sort order until fn returns false;
+    // with no order set, in the order the contacts were added.
+    template <typename Callback>
+    void forEachContact(Callback fn) const;
+    // In storage order, which removing a contact reshuffles.
     const std::vector<Contact>& getContacts() const { return contacts; }
     void saveToFile(const std::string& filename) const;
-    void loadFromFile(const std::string& filename);
+    LoadStats loadFromFile(const std::string& filename, LoadMode mode = LoadMode::Validate);
+    void clearAllContacts();
 
 private:
+    // Loaded contacts take their strings from here; the whole arena is
+    // dropped at once by clearAllContacts. Declared first so that it outlives
+    // the contacts.
+    std::pmr::monotonic_buffer_resource arena;
     std::vector<Contact> contacts;
+    IdIndex index;
+    TrigramIndex trigrams;
+    SearchKeyBuffer keys;
+    PhoneIndex phoneIndex;
+    static const size_t sortFieldCount = 5;
+    OrderedIndex orderIndexes[sortFieldCount];
+    std::vector<OrderKey> order;    // empty: byId
+    // Every contact under an empty key, so by id alone: the order they were
+    // added in, which the storage order stops being after a removal.
+    OrderedIndex byId;
+    // Packed keys for an order that is not a single ascending field.
+    OrderedIndex customOrder;
+    // Contacts with a birth date, keyed by month and day only.
+    OrderedIndex calendar;
+    uint64_t nextId = 1;
+
+    size_t slotOf(uint64_t id) const;
+    void reindex();
+    void indexContact(const Contact& c, bool withOrder = true);
+    void unindexContact(const Contact& c);
+    void rebuildOrderIndexes();
+    void verifyFrom(size_t first, LoadStats& stats);
+    static std::string sortKey(const Contact& c, SortField field);
+    static void symbolOrder(std::vector<std::string>& keys, std::vector<uint32_t>& ranks);
+    static std::string dayKey(int32_t day);
+    static std::string calendarKey(int32_t day);
+    std::vector<uint64_t> idsInRange(const OrderedIndex& ordered, size_t first, size_t last) const;
+    static std::string orderKey(const Contact& c, const std::vector<OrderKey>& keys);
+    bool customOrdered() const { return order.size() > 1 || (order.size() == 1 && order[0].descending); }
+    const OrderedIndex& currentOrder() const;
+    std::vector<uint64_t> selectRange(const std::vector<OrderKey>& keys, size_t offset, size_t count) const;
 };
 
+template <typename Callback>
+void PhoneBook::forEachMatch(const std::string& query, Callback onHit) const {
+    if (query.empty()) return;
+
+    std::string q = Validator::foldCase(query);
+    if (q.size() < 3) {
+        // Short queries match too much for posting lists to pay off.
+        keys.scan(q, [&](uint64_t id, size_t offset) {
+            return onHit(contacts[index.find(id)], SearchHit{id, offset});
+        });
+        return;
+    }
+    for (uint64_t id : trigrams.candidates(q)) {
+        size_t slot = index.find(id);
+        if (slot == IdIndex::npos) continue;
+        size_t offset = contacts[slot].getSearchKey().find(q);
+        if (offset == std::string::npos) continue;
+        if (!onHit(contacts[slot], SearchHit{id, offset})) return;
+    }
+}
+
+template <typename Callback>
+void PhoneBook::forEachContact(Callback fn) const {
+    currentOrder().forEachInRange(0, contacts.size(), [&](uint64_t id) {
+        return fn(contacts[index.find(id)]);
+    });
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,41 @@
+// phoneindex.h
+#ifndef PHONEINDEX_H
+#define PHONEINDEX_H
+
+#include "idindex.h"
+#include "phonenumber.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// Reverse index from canonical phone number (Validator::phoneKey) to the ids
+// of the contacts that have it. IdIndex points each number at the head of a
+// short chain of owners, so a lookup is one probe plus a walk of that chain.
+class PhoneIndex {
+public:
+    void add(uint64_t id, const std::pmr::vector<PhoneNumber>& phones);
+    void remove(uint64_t id, const std::pmr::vector<PhoneNumber>& phones);
+    void clear();
+
+    // First owner of the number, or 0 if nobody has it.
+    uint64_t findFirst(uint64_t key) const;
+    std::vector<uint64_t> findAll(uint64_t key) const;
+
+private:
+    static const uint32_t none = static_cast<uint32_t>(-1);
+
+    struct Entry {
+        uint64_t id;
+        uint32_t next;
+    };
+
+    IdIndex heads;
+    std::vector<Entry> entries;
+    uint32_t freeList = none;
+
+    void insert(uint64_t key, uint64_t id);
+    void erase(uint64_t key, uint64_t id);
+};
+
+#endif
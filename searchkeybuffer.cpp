@@ -0,0 +1,46 @@
+// searchkeybuffer.cpp
+#include "searchkeybuffer.h"
+
+void SearchKeyBuffer::add(uint64_t id, std::string_view key) {
+    remove(id);
+    entries.push_back(Entry{bytes.size(), id});
+    entryOf.insert(id, entries.size() - 1);
+    bytes += key;
+    bytes += '\0';
+}
+
+void SearchKeyBuffer::remove(uint64_t id) {
+    size_t i = entryOf.find(id);
+    if (i == IdIndex::npos) return;
+
+    size_t end = i + 1 < entries.size() ? entries[i + 1].start : bytes.size();
+    deadBytes += end - entries[i].start;
+    entries[i].id = 0;
+    entryOf.erase(id);
+    if (deadBytes > 4096 && deadBytes * 2 > bytes.size()) compact();
+}
+
+void SearchKeyBuffer::clear() {
+    bytes.clear();
+    entries.clear();
+    entryOf.clear();
+    deadBytes = 0;
+}
+
+void SearchKeyBuffer::compact() {
+    std::string packed;
+    std::vector<Entry> live;
+    packed.reserve(bytes.size() - deadBytes);
+    live.reserve(entryOf.size());
+    entryOf.clear();
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].id == 0) continue;
+        size_t end = i + 1 < entries.size() ? entries[i + 1].start : bytes.size();
+        live.push_back(Entry{packed.size(), entries[i].id});
+        entryOf.insert(entries[i].id, live.size() - 1);
+        packed.append(bytes, entries[i].start, end - entries[i].start);
+    }
+    bytes.swap(packed);
+    entries.swap(live);
+    deadBytes = 0;
+}
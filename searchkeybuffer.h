@@ -0,0 +1,65 @@
+// searchkeybuffer.h
+#ifndef SEARCHKEYBUFFER_H
+#define SEARCHKEYBUFFER_H
+
+#include "idindex.h"
+#include "substringscan.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// All contact search keys packed back to back into one buffer, each followed
+// by a '\0', so a brute-force search is a single SubstringScan pass instead of
+// one find() per contact. Replaced or removed keys are left in place as dead
+// entries until they make up half of the buffer.
+class SearchKeyBuffer {
+public:
+    void add(uint64_t id, std::string_view key);
+    void remove(uint64_t id);
+    void clear();
+
+    // Calls onHit(id, offset) in buffer order for every live key containing
+    // needle, until onHit returns false.
+    template <typename Callback>
+    void scan(const std::string& needle, Callback onHit) const;
+
+private:
+    struct Entry {
+        size_t start;
+        uint64_t id;    // 0 once the key is dead
+    };
+
+    std::string bytes;
+    std::vector<Entry> entries;
+    IdIndex entryOf;
+    size_t deadBytes = 0;
+
+    void compact();
+};
+
+template <typename Callback>
+void SearchKeyBuffer::scan(const std::string& needle, Callback onHit) const {
+    if (needle.empty()) return;
+
+    const char* base = bytes.data();
+    const char* end = base + bytes.size();
+    const char* from = base;
+    auto entry = entries.begin();
+    while (from < end) {
+        const char* hit = SubstringScan::find(from, end, needle.data(), needle.size());
+        if (hit == end) break;
+
+        size_t pos = static_cast<size_t>(hit - base);
+        entry = std::upper_bound(entry, entries.end(), pos,
+            [](size_t p, const Entry& e) { return p < e.start; }) - 1;
+        if (entry->id != 0 && !onHit(entry->id, pos - entry->start)) return;
+
+        auto next = entry + 1;
+        from = next == entries.end() ? end : base + next->start;
+    }
+}
+
+#endif
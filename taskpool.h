@@ -0,0 +1,69 @@
+// taskpool.h
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads with one task deque each. A worker runs its own newest task
+// first and steals the oldest task of another worker when it runs dry, so
+// work that splits itself recursively keeps every core busy.
+class TaskPool {
+public:
+    // Tasks that are waited for together.
+    class Group {
+    public:
+        Group() : pending(0) {}
+
+    private:
+        friend class TaskPool;
+        std::atomic<size_t> pending;
+        std::mutex errorMutex;
+        std::exception_ptr error;
+    };
+
+    explicit TaskPool(unsigned threads = 0);
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+    ~TaskPool();
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+    void run(Group& group, std::function<void()> task);
+    // Runs queued tasks on the calling thread until every task of the group
+    // has finished, then rethrows the first exception one of them threw.
+    void wait(Group& group);
+
+    static TaskPool& shared();
+
+private:
+    struct Task {
+        std::function<void()> fn;
+        Group* group;
+    };
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queued;
+    std::atomic<size_t> nextQueue;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    size_t homeQueue();
+    bool runOne(size_t home);
+    void workerLoop(size_t index);
+};
+
+#endif
@@ -15,7 +15,19 @@ SOURCES += \
     contact.cpp \
     phonenumber.cpp \
     validator.cpp \
-    phonebookdatabase.cpp
+    phonebookdatabase.cpp \
+    idindex.cpp \
+    trigramindex.cpp \
+    substringscan.cpp \
+    searchkeybuffer.cpp \
+    phoneindex.cpp \
+    orderedindex.cpp \
+    collation.cpp \
+    taskpool.cpp \
+    parallelsort.cpp \
+    birthdate.cpp \
+    numberingplan.cpp \
+    stringpool.cpp
 
 HEADERS += \
     mainwindow.h \
@@ -23,7 +35,19 @@ HEADERS += \
     contact.h \
     phonenumber.h \
     validator.h \
-    phonebookdatabase.h
+    phonebookdatabase.h \
+    idindex.h \
+    trigramindex.h \
+    substringscan.h \
+    searchkeybuffer.h \
+    phoneindex.h \
+    orderedindex.h \
+    collation.h \
+    taskpool.h \
+    parallelsort.h \
+    birthdate.h \
+    numberingplan.h \
+    stringpool.h
 
 # Для Qt6
 greaterThan(QT_MAJOR_VERSION, 5) {
@@ -0,0 +1,137 @@
+#include "birthdate.h"
+#include <atomic>
+#include <ctime>
+
+static constexpr int monthDays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+static constexpr bool isLeap(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static constexpr int daysInMonth(int year, int month) {
+    return month == 2 && isLeap(year) ? 29 : monthDays[month - 1];
+}
+
+static_assert(daysInMonth(2000, 2) == 29 && daysInMonth(1900, 2) == 28, "leap years");
+
+// Reads up to four digits at text[pos] and moves pos past them; returns how
+// many there were.
+static size_t readNumber(std::string_view text, size_t& pos, int& value) {
+    size_t start = pos;
+    value = 0;
+    while (pos < text.size() && pos - start < 4 && text[pos] >= '0' && text[pos] <= '9') {
+        value = value * 10 + (text[pos++] - '0');
+    }
+    return pos - start;
+}
+
+static bool isSeparator(char c) {
+    return c == '-' || c == '.' || c == '/';
+}
+
+int32_t BirthDate::parse(std::string_view text) {
+    int parts[3];
+    size_t widths[3];
+    size_t pos = 0;
+    char separator = 0;
+    for (int i = 0; i < 3; ++i) {
+        widths[i] = readNumber(text, pos, parts[i]);
+        if (widths[i] == 0) return none;
+        if (i == 2) break;
+        if (pos == text.size() || !isSeparator(text[pos])) return none;
+        if (separator && text[pos] != separator) return none;
+        separator = text[pos++];
+    }
+    if (pos != text.size()) return none;
+
+    int year, month, day;
+    if (widths[0] == 4 && widths[1] <= 2 && widths[2] <= 2) {
+        year = parts[0];
+        month = parts[1];
+        day = parts[2];
+    } else if (widths[0] <= 2 && widths[1] <= 2 && widths[2] == 4) {
+        day = parts[0];
+        month = parts[1];
+        year = parts[2];
+    } else {
+        return none;
+    }
+
+    if (month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month)) return none;
+    return fromCivil(year, month, day);
+}
+
+std::string BirthDate::format(int32_t dayNumber) {
+    if (dayNumber == none) return std::string();
+    int year, month, day;
+    toCivil(dayNumber, year, month, day);
+
+    std::string out = "0000-00-00";
+    for (int i = 3; i >= 0; --i, year /= 10) out[i] = static_cast<char>('0' + year % 10);
+    out[5] = static_cast<char>('0' + month / 10);
+    out[6] = static_cast<char>('0' + month % 10);
+    out[8] = static_cast<char>('0' + day / 10);
+    out[9] = static_cast<char>('0' + day % 10);
+    return out;
+}
+
+// Proleptic Gregorian conversions counted in 400-year eras, valid for any
+// year a four-digit field can hold.
+int32_t BirthDate::fromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+void BirthDate::toCivil(int32_t dayNumber, int& year, int& month, int& day) {
+    int z = dayNumber + 719468;
+    int era = (z >= 0 ? z : z - 146096) / 146097;
+    int dayOfEra = z - era * 146097;
+    int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int mp = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = yearOfEra + era * 400 + (month <= 2);
+}
+
+// The local date, cached with the time at which the next day starts: the day
+// number in the high half, that time_t in the low half, so one atomic load
+// gives both and a thread never pairs a day with the wrong deadline.
+static std::atomic<uint64_t> todayCache(0);
+
+static bool localDate(time_t t, struct tm& local) {
+#ifdef _WIN32
+    return localtime_s(&local, &t) == 0;
+#else
+    return localtime_r(&t, &local) != nullptr;
+#endif
+}
+
+int32_t BirthDate::today() {
+    time_t now = time(nullptr);
+    uint64_t cached = todayCache.load(std::memory_order_acquire);
+    if (static_cast<uint64_t>(now) < (cached & 0xFFFFFFFFu)) {
+        return static_cast<int32_t>(cached >> 32);
+    }
+
+    struct tm local;
+    if (!localDate(now, local)) return static_cast<int32_t>(now / 86400);
+    int32_t day = fromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+
+    // mktime() normalizes the 32nd and knows about DST, so this is the real
+    // start of tomorrow even on a 23- or 25-hour day.
+    struct tm next = local;
+    next.tm_mday += 1;
+    next.tm_hour = next.tm_min = next.tm_sec = 0;
+    next.tm_isdst = -1;
+    time_t tomorrow = mktime(&next);
+    if (tomorrow > now && static_cast<uint64_t>(tomorrow) <= 0xFFFFFFFFu) {
+        todayCache.store(static_cast<uint64_t>(static_cast<uint32_t>(day)) << 32 | static_cast<uint64_t>(tomorrow),
+                         std::memory_order_release);
+    }
+    return day;
+}
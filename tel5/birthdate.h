@@ -0,0 +1,28 @@
+#ifndef BIRTHDATE_H
+#define BIRTHDATE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Calendar dates as a signed day count from 1970-01-01, so a date is one int
+// that compares and subtracts directly.
+class BirthDate {
+public:
+    static constexpr int32_t none = INT32_MIN;
+
+    // Accepts yyyy-M-d and d-M-yyyy, with one or two digits for the month
+    // and day and the same '-', '.' or '/' between the parts. Returns none
+    // for anything else or for a day that does not exist.
+    static int32_t parse(std::string_view text);
+    // yyyy-MM-dd, or an empty string for none.
+    static std::string format(int32_t day);
+
+    static int32_t fromCivil(int year, int month, int day);
+    static void toCivil(int32_t dayNumber, int& year, int& month, int& day);
+    // The local date. Cached until the next midnight and safe to call from
+    // any thread.
+    static int32_t today();
+};
+
+#endif
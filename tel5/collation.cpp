@@ -0,0 +1,42 @@
+#include "collation.h"
+
+std::string Collation::key(std::string_view text) {
+    std::string out;
+    appendKey(out, text);
+    return out;
+}
+
+// Russian letters (U+0410..U+044F, U+0401, U+0451) become one byte each in
+// 0x80..0xA0, below every UTF-8 lead byte, so they sort after ASCII and before
+// any other script. Everything else keeps its UTF-8 bytes.
+void Collation::appendKey(std::string& out, std::string_view text) {
+    out.reserve(out.size() + text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 'A' && c <= 'Z') {
+            out += static_cast<char>(c + 0x20);
+            continue;
+        }
+        unsigned char n = i + 1 < text.size() ? static_cast<unsigned char>(text[i + 1]) : 0;
+        if ((c != 0xD0 && c != 0xD1) || (n & 0xC0) != 0x80) {
+            out += static_cast<char>(c);
+            continue;
+        }
+
+        unsigned code = ((c & 0x1Fu) << 6) | (n & 0x3Fu);
+        if (code >= 0x410 && code <= 0x42F) {
+            code += 0x20;
+        }
+        if (code == 0x401 || code == 0x451) {
+            out += static_cast<char>(0x86);
+        } else if (code >= 0x430 && code <= 0x435) {
+            out += static_cast<char>(0x80 + (code - 0x430));
+        } else if (code >= 0x436 && code <= 0x44F) {
+            out += static_cast<char>(0x81 + (code - 0x430));
+        } else {
+            out += static_cast<char>(c);
+            out += static_cast<char>(n);
+        }
+        ++i;
+    }
+}
@@ -1,12 +1,19 @@
 #include "contact.h"
 #include "validator.h"
+#include <charconv>
 #include <sstream>
 #include <algorithm>
 #include <stdexcept>
 #include <iostream>
 
+Contact::Contact(const allocator_type& alloc)
+    : lastName(alloc), emailLocal(alloc), phones(alloc), searchKey(alloc)
+{
+}
+
 Contact::Contact(const std::string& firstName, const std::string& lastName,
                  const std::string& email, const PhoneNumber& phone)
+    : Contact(allocator_type())
 {
     setFirstName(firstName);
     setLastName(lastName);
@@ -14,43 +21,76 @@ Contact::Contact(const std::string& firstName, const std::string& lastName,
     addPhone(phone);
 }
 
-void Contact::setFirstName(const std::string& name) {
-    if (!Validator::validateName(name)) {
-        throw std::invalid_argument("Invalid first name");
+Contact::Contact(const Contact& other, const allocator_type& alloc)
+    : id(other.id), firstName(other.firstName), lastName(other.lastName, alloc),
+      middleName(other.middleName), address(other.address), birthDay(other.birthDay),
+      emailLocal(other.emailLocal, alloc), emailDomain(other.emailDomain), phones(other.phones, alloc),
+      searchKey(other.searchKey, alloc)
+{
+}
+
+Contact::Contact(Contact&& other, const allocator_type& alloc)
+    : id(other.id), firstName(other.firstName), lastName(std::move(other.lastName), alloc),
+      middleName(other.middleName), address(other.address), birthDay(other.birthDay),
+      emailLocal(std::move(other.emailLocal), alloc), emailDomain(other.emailDomain),
+      phones(std::move(other.phones), alloc), searchKey(std::move(other.searchKey), alloc)
+{
+}
+
+static std::string accept(Normalized&& field, const char* error) {
+    if (!field) {
+        throw std::invalid_argument(error);
     }
-    firstName = Validator::trim(name);
+    return std::move(field.value);
+}
+
+void Contact::setFirstName(const std::string& name) {
+    firstName = StringPool::shared().intern(accept(Validator::normalizeName(name), "Invalid first name"));
+    updateSearchKey();
 }
 
 void Contact::setLastName(const std::string& name) {
-    if (!Validator::validateName(name)) {
-        throw std::invalid_argument("Invalid last name");
-    }
-    lastName = Validator::trim(name);
+    lastName = accept(Validator::normalizeName(name), "Invalid last name");
+    updateSearchKey();
 }
 
 void Contact::setMiddleName(const std::string& name) {
-    if (!name.empty() && !Validator::validateName(name)) {
-        throw std::invalid_argument("Invalid middle name");
+    Normalized middle = Validator::normalizeName(name);
+    if (middle.error == ValidationError::Empty) {
+        middle.error = ValidationError::None;
     }
-    middleName = Validator::trim(name);
+    middleName = StringPool::shared().intern(accept(std::move(middle), "Invalid middle name"));
+    updateSearchKey();
 }
 
 void Contact::setAddress(const std::string& addr) {
-    address = Validator::trim(addr);
+    address = StringPool::shared().intern(Validator::trimmed(addr));
 }
 
 void Contact::setBirthDate(const std::string& date) {
-    if (!date.empty() && !Validator::validateDate(date)) {
+    int32_t day;
+    if (Validator::checkBirthDate(date, day) != ValidationError::None) {
         throw std::invalid_argument("Invalid birth date");
     }
-    birthDate = date;
+    birthDay = day;
 }
 
 void Contact::setEmail(const std::string& mail) {
-    if (!Validator::validateEmail(mail)) {
-        throw std::invalid_argument("Invalid email");
+    assignEmail(accept(Validator::normalizeEmail(mail), "Invalid email"));
+    updateSearchKey();
+}
+
+void Contact::assignEmail(std::string_view mail) {
+    size_t at = mail.find('@');
+    emailLocal = mail.substr(0, at);
+    emailDomain = at == std::string_view::npos ? 0 : StringPool::shared().intern(mail.substr(at));
+}
+
+std::string_view Contact::getEmailDomain() const {
+    if (!emailDomain) {
+        return std::string_view();
     }
-    email = Validator::trim(mail);
+    return std::string_view(StringPool::shared().text(emailDomain)).substr(1);
 }
 
 void Contact::addPhone(const PhoneNumber& phone) {
@@ -64,14 +104,26 @@ void Contact::removePhone(size_t index) {
     phones.erase(phones.begin() + index);
 }
 
+void Contact::updateSearchKey() {
+    searchKey.clear();
+    Validator::appendFolded(searchKey, getFirstName());
+    searchKey += ' ';
+    Validator::appendFolded(searchKey, lastName);
+    searchKey += '\n';
+    Validator::appendFolded(searchKey, getMiddleName());
+    searchKey += '\n';
+    Validator::appendFolded(searchKey, emailLocal);
+    Validator::appendFolded(searchKey, StringPool::shared().text(emailDomain));
+}
+
 std::string Contact::toString() const {
     std::ostringstream oss;
-    oss << firstName << ";" 
+    oss << getFirstName() << ";" 
         << lastName << ";" 
-        << middleName << ";" 
-        << address << ";" 
-        << birthDate << ";" 
-        << email << ";phones:";
+        << getMiddleName() << ";" 
+        << getAddress() << ";" 
+        << getBirthDate() << ";" 
+        << emailLocal << StringPool::shared().text(emailDomain) << ";phones:";
     
     for (const auto& phone : phones) {
         oss << "(" << static_cast<int>(phone.getType()) 
@@ -81,59 +133,216 @@ std::string Contact::toString() const {
     return oss.str();
 }
 
+const char* Contact::fieldName(ContactField field) {
+    switch (field) {
+    case ContactField::FirstName:
+        return "first name";
+    case ContactField::LastName:
+        return "last name";
+    case ContactField::MiddleName:
+        return "middle name";
+    case ContactField::BirthDate:
+        return "birth date";
+    case ContactField::Email:
+        return "email";
+    case ContactField::Phone:
+        return "phone";
+    default:
+        return "record";
+    }
+}
+
 Contact Contact::fromString(const std::string& str) {
-    std::stringstream ss(str);
-    std::string token;
-    std::vector<std::string> tokens;
-    
-    while (std::getline(ss, token, ';')) {
-        tokens.push_back(token);
+    ParseResult parsed = tryParse(str);
+    if (!parsed) {
+        if (parsed.field == ContactField::Record) {
+            throw std::invalid_argument("Invalid contact string format");
+        }
+        throw std::invalid_argument(std::string("Invalid ") + fieldName(parsed.field));
     }
-    
-    if (tokens.size() < 6) {
-        throw std::invalid_argument("Invalid contact string format");
+    return std::move(*parsed.contact);
+}
+
+static ParseResult reject(ContactField field, ValidationError error) {
+    ParseResult result;
+    result.field = field;
+    result.error = error;
+    return result;
+}
+
+// Splits "first;last;middle;address;birth;email[;phones:(type,number)...]"
+// into at most seven tokens and returns how many there were.
+static size_t splitTokens(std::string_view line, std::string_view (&tokens)[7]) {
+    size_t count = 0;
+    for (size_t pos = 0; count < 7; ) {
+        size_t end = line.find(';', pos);
+        tokens[count++] = line.substr(pos, end == std::string_view::npos ? end : end - pos);
+        if (end == std::string_view::npos) {
+            break;
+        }
+        pos = end + 1;
     }
-    
-    PhoneNumber defaultPhone(PhoneType::Work, "80000000000");
-    Contact contact(tokens[0], tokens[1], tokens[5], defaultPhone);
-    
-    contact.setMiddleName(tokens[2]);
-    contact.setAddress(tokens[3]);
-    contact.setBirthDate(tokens[4]);
-    
-    contact.phones.clear();
-    
-    if (tokens.size() > 6 && tokens[6].find("phones:") == 0) {
-        std::string phonesStr = tokens[6].substr(7);
-        std::string phoneToken;
-        size_t pos = 0;
-        
-        while (pos < phonesStr.length()) {
-            if (phonesStr[pos] == '(') {
-                size_t endPos = phonesStr.find(')', pos);
-                if (endPos != std::string::npos) {
-                    std::string phoneData = phonesStr.substr(pos + 1, endPos - pos - 1);
-                    size_t commaPos = phoneData.find(',');
-                    
-                    if (commaPos != std::string::npos) {
-                        try {
-                            int type = std::stoi(phoneData.substr(0, commaPos));
-                            std::string number = phoneData.substr(commaPos + 1);
-                            PhoneNumber phone(static_cast<PhoneType>(type), number);
-                            contact.addPhone(phone);
-                        } catch (...) {
-        
-                        }
-                    }
-                    pos = endPos + 1;
-                } else {
-                    break;
-                }
-            } else {
-                pos++;
-            }
+    return count;
+}
+
+// Reads "phones:(type,number)...". A pair that does not parse or has no valid
+// key is skipped in every load mode; returns how many were. Saved numbers look
+// like "8 (916) 123-45-67", so a pair ends at the ')' before the next pair,
+// not at the first one.
+static size_t parsePhones(std::string_view token, std::pmr::vector<PhoneNumber>& phones) {
+    size_t skipped = 0;
+    if (token.substr(0, 7) != "phones:") {
+        return skipped;
+    }
+    std::string_view phonesStr = token.substr(7);
+    size_t pos = 0;
+    while (pos < phonesStr.length()) {
+        if (phonesStr[pos] != '(') {
+            pos++;
+            continue;
+        }
+        size_t endPos = phonesStr.find(")(", pos);
+        if (endPos == std::string_view::npos) {
+            endPos = phonesStr.rfind(')');
+        }
+        if (endPos == std::string_view::npos || endPos < pos) {
+            break;
+        }
+        std::string_view phoneData = phonesStr.substr(pos + 1, endPos - pos - 1);
+        pos = endPos + 1;
+
+        size_t commaPos = phoneData.find(',');
+        int type = -1;
+        if (commaPos == std::string_view::npos ||
+            std::from_chars(phoneData.data(), phoneData.data() + commaPos, type).ptr != phoneData.data() + commaPos ||
+            type < 0 || type > static_cast<int>(PhoneType::Office)) {
+            ++skipped;
+            continue;
+        }
+        PhoneNumber phone = PhoneNumber::trusted(static_cast<PhoneType>(type), phoneData.substr(commaPos + 1));
+        if (phone.getKey() == 0) {
+            ++skipped;
+        } else {
+            phones.push_back(phone);
         }
     }
-    
+    return skipped;
+}
+
+// Validates a line without throwing. Bad phones are skipped, as before.
+ParseResult Contact::tryParse(std::string_view line, const allocator_type& alloc) {
+    std::string_view tokens[7];
+    size_t count = splitTokens(line, tokens);
+    if (count < 6) {
+        return reject(ContactField::Record, ValidationError::MissingField);
+    }
+
+    ContactFields fields(alloc);
+    Normalized first = Validator::normalizeName(tokens[0]);
+    if (!first) {
+        return reject(ContactField::FirstName, first.error);
+    }
+    Normalized last = Validator::normalizeName(tokens[1]);
+    if (!last) {
+        return reject(ContactField::LastName, last.error);
+    }
+    Normalized middle = Validator::normalizeName(tokens[2]);
+    if (!middle && middle.error != ValidationError::Empty) {
+        return reject(ContactField::MiddleName, middle.error);
+    }
+    ValidationError dateError = Validator::checkBirthDate(tokens[4], fields.birthDay);
+    if (dateError != ValidationError::None) {
+        return reject(ContactField::BirthDate, dateError);
+    }
+    Normalized mail = Validator::normalizeEmail(tokens[5]);
+    if (!mail) {
+        return reject(ContactField::Email, mail.error);
+    }
+
+    fields.firstName = first.value;
+    fields.lastName = last.value;
+    fields.middleName = middle.value;
+    fields.address = Validator::trimmed(tokens[3]);
+    fields.email = mail.value;
+    size_t skipped = 0;
+    if (count > 6) {
+        skipped = parsePhones(tokens[6], fields.phones);
+    }
+
+    ParseResult result;
+    result.contact = trusted(std::move(fields));
+    result.skippedPhones = skipped;
+    return result;
+}
+
+ParseResult Contact::parseTrusted(std::string_view line, const allocator_type& alloc) {
+    std::string_view tokens[7];
+    size_t count = splitTokens(line, tokens);
+    if (count < 6) {
+        return reject(ContactField::Record, ValidationError::MissingField);
+    }
+
+    ContactFields fields(alloc);
+    fields.firstName = tokens[0];
+    fields.lastName = tokens[1];
+    fields.middleName = tokens[2];
+    fields.address = tokens[3];
+    if (!tokens[4].empty()) {
+        fields.birthDay = BirthDate::parse(tokens[4]);
+        if (fields.birthDay == BirthDate::none) {
+            return reject(ContactField::BirthDate, ValidationError::BadDate);
+        }
+    }
+    fields.email = tokens[5];
+    size_t skipped = 0;
+    if (count > 6) {
+        skipped = parsePhones(tokens[6], fields.phones);
+    }
+
+    ParseResult result;
+    result.contact = trusted(std::move(fields));
+    result.skippedPhones = skipped;
+    return result;
+}
+
+Contact Contact::trusted(ContactFields&& fields) {
+    StringPool& pool = StringPool::shared();
+    Contact contact(fields.lastName.get_allocator());
+    contact.firstName = pool.intern(fields.firstName);
+    contact.lastName = std::move(fields.lastName);
+    contact.middleName = pool.intern(fields.middleName);
+    contact.address = pool.intern(fields.address);
+    contact.assignEmail(fields.email);
+    contact.birthDay = fields.birthDay;
+    contact.phones = std::move(fields.phones);
+    contact.updateSearchKey();
     return contact;
 }
+
+ValidationError Contact::verify(ContactField& field) const {
+    ValidationError error = Validator::checkName(getFirstName());
+    if (error != ValidationError::None) {
+        field = ContactField::FirstName;
+        return error;
+    }
+    error = Validator::checkName(lastName);
+    if (error != ValidationError::None) {
+        field = ContactField::LastName;
+        return error;
+    }
+    error = Validator::checkName(getMiddleName());
+    if (error != ValidationError::None && error != ValidationError::Empty) {
+        field = ContactField::MiddleName;
+        return error;
+    }
+    if (birthDay != BirthDate::none && !Validator::validateBirthDay(birthDay)) {
+        field = ContactField::BirthDate;
+        return ValidationError::BadDate;
+    }
+    error = Validator::checkEmail(emailLocal, StringPool::shared().text(emailDomain));
+    if (error != ValidationError::None) {
+        field = ContactField::Email;
+        return error;
+    }
+    return ValidationError::None;
+}
@@ -2,21 +2,75 @@
 #define CONTACT_H
 
 #include "phonenumber.h"
+#include "birthdate.h"
+#include "validator.h"
+#include "stringpool.h"
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
+// The part of a saved line that was rejected; Record means the line itself.
+enum class ContactField { Record, FirstName, LastName, MiddleName, BirthDate, Email, Phone };
+
+// Fields that were validated before they were stored, moved into
+// Contact::trusted() as they are. Fill them through the allocator of the
+// contact they are meant for, and the move costs nothing. The views are
+// interned or split by trusted() and only have to outlive that call, so they
+// can point straight into the line being parsed.
+struct ContactFields {
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    explicit ContactFields(const allocator_type& alloc = {})
+        : lastName(alloc), phones(alloc) {}
+
+    std::string_view firstName, middleName, address, email;
+    std::pmr::string lastName;
+    int32_t birthDay = BirthDate::none;
+    std::pmr::vector<PhoneNumber> phones;
+};
+
+struct ParseResult;
+
+// Allocator-aware: the strings and the phone list come from the memory
+// resource the contact was built with, so a bulk load can put them all in
+// one arena. A plain copy uses the default resource again.
+// First and middle name, address and email domain repeat across contacts and
+// are kept as StringPool::shared() symbols instead; comparing two symbols
+// compares the texts.
 class Contact {
 public:
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
     Contact(const std::string& firstName, const std::string& lastName,
             const std::string& email, const PhoneNumber& phone);
+    Contact(const Contact& other, const allocator_type& alloc);
+    Contact(Contact&& other, const allocator_type& alloc);
+    Contact(const Contact& other) = default;
+    Contact(Contact&& other) = default;
+    Contact& operator=(const Contact& other) = default;
+    Contact& operator=(Contact&& other) = default;
+    allocator_type get_allocator() const { return lastName.get_allocator(); }
 
-    std::string getFirstName() const { return firstName; }
-    std::string getLastName() const { return lastName; }
-    std::string getMiddleName() const { return middleName; }
-    std::string getAddress() const { return address; }
-    std::string getBirthDate() const { return birthDate; }
-    std::string getEmail() const { return email; }
-    const std::vector<PhoneNumber>& getPhones() const { return phones; }
+    const std::string& getFirstName() const { return StringPool::shared().text(firstName); }
+    const std::pmr::string& getLastName() const { return lastName; }
+    const std::string& getMiddleName() const { return StringPool::shared().text(middleName); }
+    const std::string& getAddress() const { return StringPool::shared().text(address); }
+    std::string getBirthDate() const { return BirthDate::format(birthDay); }
+    int32_t getBirthDay() const { return birthDay; }
+    std::string getEmail() const { return std::string(emailLocal) + StringPool::shared().text(emailDomain); }
+    // Everything after the first '@' of the canonical email; empty if it has
+    // no '@'.
+    std::string_view getEmailDomain() const;
+    StringPool::Symbol getFirstNameSymbol() const { return firstName; }
+    StringPool::Symbol getMiddleNameSymbol() const { return middleName; }
+    StringPool::Symbol getAddressSymbol() const { return address; }
+    StringPool::Symbol getEmailDomainSymbol() const { return emailDomain; }
+    const std::pmr::vector<PhoneNumber>& getPhones() const { return phones; }
+    uint64_t getId() const { return id; }
+    const std::pmr::string& getSearchKey() const { return searchKey; }
 
     void setFirstName(const std::string& name);
     void setLastName(const std::string& name);
@@ -30,15 +84,49 @@ public:
 
     std::string toString() const;
     static Contact fromString(const std::string& str);
+    // Same as fromString, but a bad line is reported in the result rather
+    // than thrown, so loading a dirty file costs no stack unwinding.
+    static ParseResult tryParse(std::string_view line, const allocator_type& alloc = {});
+    static const char* fieldName(ContactField field);
+    // Builds a contact from our own snapshot or database without validating
+    // or trimming anything.
+    static Contact trusted(ContactFields&& fields);
+    // tryParse for lines saveToFile wrote: only the layout is checked, and
+    // that a birth date, if there is one, reads as a date.
+    static ParseResult parseTrusted(std::string_view line, const allocator_type& alloc = {});
+    // Re-checks the fields of a trusted contact; on failure sets field. Phones
+    // are not checked: parsing already skipped those without a valid key.
+    ValidationError verify(ContactField& field) const;
 
 private:
-    std::string firstName;
-    std::string lastName;
-    std::string middleName;
-    std::string address;
-    std::string birthDate;
-    std::string email;
-    std::vector<PhoneNumber> phones;
+    friend class PhoneBook;
+
+    explicit Contact(const allocator_type& alloc);
+
+    uint64_t id = 0;
+    StringPool::Symbol firstName = 0;
+    std::pmr::string lastName;
+    StringPool::Symbol middleName = 0;
+    StringPool::Symbol address = 0;
+    int32_t birthDay = BirthDate::none;    // day number, parsed once by setBirthDate
+    // The email up to its first '@', and the rest, '@' included, interned.
+    std::pmr::string emailLocal;
+    StringPool::Symbol emailDomain = 0;
+    std::pmr::vector<PhoneNumber> phones;
+    // Case-folded "first last\nmiddle\nemail", rebuilt by the name and email setters.
+    std::pmr::string searchKey;
+
+    void updateSearchKey();
+    void assignEmail(std::string_view mail);
+};
+
+struct ParseResult {
+    std::optional<Contact> contact;             // set when the line was accepted
+    ContactField field = ContactField::Record;  // otherwise what was wrong, and why
+    ValidationError error = ValidationError::None;
+    size_t skippedPhones = 0;                   // bad phones dropped from an accepted line
+
+    explicit operator bool() const { return contact.has_value(); }
 };
 
 #endif // CONTACT_H
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "idindex.h"
+
+IdIndex::IdIndex() : buckets(16, Bucket{0, 0}), count(0), mask(15) {}
+
+uint64_t IdIndex::hash(uint64_t id) {
+    id ^= id >> 33;
+    id *= 0xff51afd7ed558ccdULL;
+    id ^= id >> 33;
+    return id;
+}
+
+void IdIndex::insert(uint64_t id, size_t slot) {
+    if ((count + 1) * 4 > buckets.size() * 3) rehash(buckets.size() * 2);
+
+    size_t i = hash(id) & mask;
+    while (buckets[i].id != 0) {
+        if (buckets[i].id == id) {
+            buckets[i].slot = slot;
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+    buckets[i].id = id;
+    buckets[i].slot = slot;
+    ++count;
+}
+
+size_t IdIndex::find(uint64_t id) const {
+    if (id == 0) return npos;
+    size_t i = hash(id) & mask;
+    while (buckets[i].id != 0) {
+        if (buckets[i].id == id) return buckets[i].slot;
+        i = (i + 1) & mask;
+    }
+    return npos;
+}
+
+bool IdIndex::erase(uint64_t id) {
+    if (id == 0) return false;
+    size_t i = hash(id) & mask;
+    while (buckets[i].id != id) {
+        if (buckets[i].id == 0) return false;
+        i = (i + 1) & mask;
+    }
+
+    // Shift following entries of the probe run back into the hole.
+    size_t hole = i;
+    size_t j = i;
+    while (true) {
+        j = (j + 1) & mask;
+        if (buckets[j].id == 0) break;
+        size_t home = hash(buckets[j].id) & mask;
+        if (((j - home) & mask) >= ((j - hole) & mask)) {
+            buckets[hole] = buckets[j];
+            hole = j;
+        }
+    }
+    buckets[hole].id = 0;
+    --count;
+    return true;
+}
+
+void IdIndex::clear() {
+    buckets.assign(16, Bucket{0, 0});
+    count = 0;
+    mask = 15;
+}
+
+void IdIndex::reserve(size_t n) {
+    size_t capacity = buckets.size();
+    while (n * 4 > capacity * 3) capacity *= 2;
+    if (capacity != buckets.size()) rehash(capacity);
+}
+
+void IdIndex::rehash(size_t newCapacity) {
+    std::vector<Bucket> old;
+    old.swap(buckets);
+    buckets.assign(newCapacity, Bucket{0, 0});
+    mask = newCapacity - 1;
+    count = 0;
+    for (const auto& b : old) {
+        if (b.id != 0) insert(b.id, b.slot);
+    }
+}
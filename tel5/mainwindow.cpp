@@ -11,6 +11,7 @@
 #include <QPushButton>
 #include <QComboBox>
 #include <QDateEdit>
+#include <QSpinBox>
 #include <QListWidget>
 #include <QMenuBar>
 #include <QMenu>
@@ -28,6 +29,7 @@
 #include <QButtonGroup>
 #include <stdexcept>
 #include <iostream>
+#include <unordered_set>
 
 const QString MainWindow::DEFAULT_FILENAME = "phonebook.txt";
 
@@ -42,6 +44,11 @@ MainWindow::MainWindow(QWidget *parent)
     , sortComboBox(nullptr)
     , sortButton(nullptr)
     , clearButton(nullptr)
+    , birthdayDaysSpin(nullptr)
+    , birthdaysButton(nullptr)
+    , bornFromEdit(nullptr)
+    , bornToEdit(nullptr)
+    , bornBetweenButton(nullptr)
     , firstNameEdit(nullptr)
     , lastNameEdit(nullptr)
     , middleNameEdit(nullptr)
@@ -60,7 +67,7 @@ MainWindow::MainWindow(QWidget *parent)
     , clearDatabaseAction(nullptr)
     , initializeDatabaseAction(nullptr)
     , statusLabel(nullptr)
-    , currentEditIndex(-1)
+    , currentEditId(0)
 {
     setupUI();
     setupStorageMenu();
@@ -78,7 +85,7 @@ MainWindow::~MainWindow() {
 
 void MainWindow::loadContacts() {
     try {
-        phoneBook.loadFromFile(DEFAULT_FILENAME.toStdString());
+        phoneBook.loadFromFile(DEFAULT_FILENAME.toStdString(), LoadMode::Trusted);
     } catch (const std::exception& e) {
         std::cout << "Примечание: " << e.what() << std::endl;
     }
@@ -107,7 +114,7 @@ void MainWindow::setupUI() {
     
     QHBoxLayout* searchLayout = new QHBoxLayout();
     searchLineEdit = new QLineEdit(this);
-    searchLineEdit->setPlaceholderText("Поиск по имени, фамилии или email...");
+    searchLineEdit->setPlaceholderText("Поиск по имени, фамилии, email или телефону...");
     searchButton = new QPushButton("Поиск", this);
     searchButton->setFixedWidth(100);
     searchLayout->addWidget(searchLineEdit);
@@ -117,7 +124,8 @@ void MainWindow::setupUI() {
     
     QHBoxLayout* sortLayout = new QHBoxLayout();
     sortComboBox = new QComboBox(this);
-    sortComboBox->addItems({"Фамилия", "Имя", "Email", "Дата рождения"});
+    sortComboBox->addItems({"Фамилия", "Имя", "Email", "Дата рождения",
+                            "Фамилия, имя, отчество", "Дата рождения (по убыванию)"});
     sortButton = new QPushButton("Сортировать", this);
     sortButton->setFixedWidth(100);
     sortLayout->addWidget(new QLabel("Сортировка:", this));
@@ -125,6 +133,31 @@ void MainWindow::setupUI() {
     sortLayout->addWidget(sortButton);
     connect(sortButton, &QPushButton::clicked, this, &MainWindow::sortContacts);
     
+    QHBoxLayout* birthdayLayout = new QHBoxLayout();
+    birthdayDaysSpin = new QSpinBox(this);
+    birthdayDaysSpin->setRange(1, 366);
+    birthdayDaysSpin->setValue(7);
+    birthdayDaysSpin->setSuffix(" дн.");
+    birthdaysButton = new QPushButton("Дни рождения", this);
+    bornFromEdit = new QDateEdit(this);
+    bornFromEdit->setDisplayFormat("dd-MM-yyyy");
+    bornFromEdit->setCalendarPopup(true);
+    bornFromEdit->setDate(QDate(1900, 1, 1));
+    bornToEdit = new QDateEdit(this);
+    bornToEdit->setDisplayFormat("dd-MM-yyyy");
+    bornToEdit->setCalendarPopup(true);
+    bornToEdit->setDate(QDate::currentDate());
+    bornBetweenButton = new QPushButton("Родились между", this);
+    birthdayLayout->addWidget(new QLabel("Ближайшие:", this));
+    birthdayLayout->addWidget(birthdayDaysSpin);
+    birthdayLayout->addWidget(birthdaysButton);
+    birthdayLayout->addStretch();
+    birthdayLayout->addWidget(bornFromEdit);
+    birthdayLayout->addWidget(bornToEdit);
+    birthdayLayout->addWidget(bornBetweenButton);
+    connect(birthdaysButton, &QPushButton::clicked, this, &MainWindow::showUpcomingBirthdays);
+    connect(bornBetweenButton, &QPushButton::clicked, this, &MainWindow::showBornBetween);
+    
     tableWidget = new QTableWidget(this);
     tableWidget->setColumnCount(7);
     tableWidget->setHorizontalHeaderLabels({
@@ -159,6 +192,7 @@ void MainWindow::setupUI() {
     
     leftLayout->addLayout(searchLayout);
     leftLayout->addLayout(sortLayout);
+    leftLayout->addLayout(birthdayLayout);
     leftLayout->addWidget(tableWidget, 1);
     leftLayout->addLayout(tableButtonsLayout);
     
@@ -299,40 +333,52 @@ void MainWindow::setupStorageMenu() {
 
 void MainWindow::updateTable() {
     tableWidget->setRowCount(0);
-    const auto& contacts = phoneBook.getContacts();
     
-    for (size_t i = 0; i < contacts.size(); ++i) {
-        const Contact& c = contacts[i];
-        int row = tableWidget->rowCount();
-        tableWidget->insertRow(row);
-        
-        tableWidget->setItem(row, 0, new QTableWidgetItem(QString::number(i + 1)));
-        
-        tableWidget->setItem(row, 1, new QTableWidgetItem(
-            QString::fromUtf8(c.getLastName().c_str())));
-        
-        tableWidget->setItem(row, 2, new QTableWidgetItem(
-            QString::fromUtf8(c.getFirstName().c_str())));
-        
-        QString middleName = QString::fromUtf8(c.getMiddleName().c_str());
-        if (middleName.isEmpty()) middleName = "-";
-        tableWidget->setItem(row, 3, new QTableWidgetItem(middleName));
-        
-        QString birthDate = QString::fromUtf8(c.getBirthDate().c_str());
-        if (birthDate.isEmpty()) birthDate = "Не указана";
-        tableWidget->setItem(row, 4, new QTableWidgetItem(birthDate));
-        
-        tableWidget->setItem(row, 5, new QTableWidgetItem(
-            QString::fromUtf8(c.getEmail().c_str())));
-        
-        QString phones;
-        const auto& phoneList = c.getPhones();
-        for (size_t j = 0; j < phoneList.size(); ++j) {
-            if (j > 0) phones += ", ";
-            phones += QString::fromUtf8(phoneList[j].getNumber().c_str());
-        }
-        tableWidget->setItem(row, 6, new QTableWidgetItem(phones));
+    phoneBook.forEachContact([this](const Contact& c) {
+        addTableRow(c);
+        return true;
+    });
+}
+
+void MainWindow::showContacts(const std::vector<uint64_t>& ids) {
+    tableWidget->setRowCount(0);
+    for (uint64_t id : ids) {
+        addTableRow(phoneBook.getContact(id));
+    }
+}
+
+void MainWindow::addTableRow(const Contact& c) {
+    int row = tableWidget->rowCount();
+    tableWidget->insertRow(row);
+    
+    QTableWidgetItem* idItem = new QTableWidgetItem(QString::number(c.getId()));
+    idItem->setData(Qt::UserRole, QVariant::fromValue<qulonglong>(c.getId()));
+    tableWidget->setItem(row, 0, idItem);
+    
+    tableWidget->setItem(row, 1, new QTableWidgetItem(
+        QString::fromUtf8(c.getLastName().c_str())));
+    
+    tableWidget->setItem(row, 2, new QTableWidgetItem(
+        QString::fromUtf8(c.getFirstName().c_str())));
+    
+    QString middleName = QString::fromUtf8(c.getMiddleName().c_str());
+    if (middleName.isEmpty()) middleName = "-";
+    tableWidget->setItem(row, 3, new QTableWidgetItem(middleName));
+    
+    QString birthDate = QString::fromUtf8(c.getBirthDate().c_str());
+    if (birthDate.isEmpty()) birthDate = "Не указана";
+    tableWidget->setItem(row, 4, new QTableWidgetItem(birthDate));
+    
+    tableWidget->setItem(row, 5, new QTableWidgetItem(
+        QString::fromUtf8(c.getEmail().c_str())));
+    
+    QString phones;
+    const auto& phoneList = c.getPhones();
+    for (size_t j = 0; j < phoneList.size(); ++j) {
+        if (j > 0) phones += ", ";
+        phones += QString::fromUtf8(phoneList[j].getNumber().c_str());
     }
+    tableWidget->setItem(row, 6, new QTableWidgetItem(phones));
 }
 
 void MainWindow::addContact() {
@@ -348,17 +394,17 @@ void MainWindow::addContact() {
 }
 
 void MainWindow::editContact() {
-    if (currentEditIndex < 0 || currentEditIndex >= static_cast<int>(phoneBook.getContacts().size())) {
+    if (!phoneBook.hasContact(currentEditId)) {
         showError("Выберите контакт для редактирования");
         return;
     }
     
     try {
         Contact contact = getContactFromForm();
-        phoneBook.editContact(currentEditIndex, contact);
+        phoneBook.editContact(currentEditId, contact);
         updateTable();
         clearForm();
-        currentEditIndex = -1;
+        currentEditId = 0;
         editButton->setEnabled(false);
         deleteButton->setEnabled(false);
         showInfo("Контакт успешно обновлен");
@@ -368,7 +414,7 @@ void MainWindow::editContact() {
 }
 
 void MainWindow::deleteContact() {
-    if (currentEditIndex < 0 || currentEditIndex >= static_cast<int>(phoneBook.getContacts().size())) {
+    if (!phoneBook.hasContact(currentEditId)) {
         showError("Выберите контакт для удаления");
         return;
     }
@@ -382,10 +428,10 @@ void MainWindow::deleteContact() {
     
     if (reply == QMessageBox::Yes) {
         try {
-            phoneBook.removeContact(currentEditIndex);
+            phoneBook.removeContact(currentEditId);
             updateTable();
             clearForm();
-            currentEditIndex = -1;
+            currentEditId = 0;
             editButton->setEnabled(false);
             deleteButton->setEnabled(false);
             showInfo("Контакт успешно удален");
@@ -402,16 +448,19 @@ void MainWindow::searchContacts() {
         return;
     }
     
+    std::unordered_set<uint64_t> matched;
+    phoneBook.forEachMatch(query.toStdString(), [&matched](const Contact&, const SearchHit& hit) {
+        matched.insert(hit.id);
+        return true;
+    });
+    for (uint64_t id : phoneBook.findAllByPhone(query.toStdString())) {
+        matched.insert(id);
+    }
+    
     for (int row = 0; row < tableWidget->rowCount(); ++row) {
-        bool found = false;
-        for (int col = 1; col <= 5; ++col) { 
-            QTableWidgetItem* item = tableWidget->item(row, col);
-            if (item && item->text().contains(query, Qt::CaseInsensitive)) {
-                found = true;
-                break;
-            }
-        }
-        tableWidget->setRowHidden(row, !found);
+        QTableWidgetItem* idItem = tableWidget->item(row, 0);
+        uint64_t id = idItem ? idItem->data(Qt::UserRole).toULongLong() : 0;
+        tableWidget->setRowHidden(row, matched.count(id) == 0);
     }
 }
 
@@ -423,6 +472,8 @@ void MainWindow::sortContacts() {
     else if (field == "Имя") fieldStr = "name";
     else if (field == "Email") fieldStr = "email";
     else if (field == "Дата рождения") fieldStr = "birthdate";
+    else if (field == "Фамилия, имя, отчество") fieldStr = "last,first,middle";
+    else if (field == "Дата рождения (по убыванию)") fieldStr = "-birthdate,last,first";
     
     if (phoneBook.sortByField(fieldStr)) {
         updateTable();
@@ -430,26 +481,38 @@ void MainWindow::sortContacts() {
     }
 }
 
+void MainWindow::showUpcomingBirthdays() {
+    int days = birthdayDaysSpin->value();
+    std::vector<uint64_t> ids = phoneBook.upcomingBirthdays(days);
+    showContacts(ids);
+    showInfo(QString("Дней рождения в ближайшие %1 дн.: %2").arg(days).arg(static_cast<int>(ids.size())));
+}
+
+void MainWindow::showBornBetween() {
+    QDate from = bornFromEdit->date();
+    QDate to = bornToEdit->date();
+    std::vector<uint64_t> ids = phoneBook.bornBetween(
+        BirthDate::fromCivil(from.year(), from.month(), from.day()),
+        BirthDate::fromCivil(to.year(), to.month(), to.day()));
+    showContacts(ids);
+    showInfo(QString("Найдено контактов: %1").arg(static_cast<int>(ids.size())));
+}
+
 void MainWindow::onTableSelectionChanged() {
     QList<QTableWidgetItem*> items = tableWidget->selectedItems();
     if (items.isEmpty()) {
         editButton->setEnabled(false);
         deleteButton->setEnabled(false);
-        currentEditIndex = -1;
+        currentEditId = 0;
         return;
     }
     
     int row = items.first()->row();
     QTableWidgetItem* idItem = tableWidget->item(row, 0);
-    if (idItem) {
-        currentEditIndex = idItem->text().toInt() - 1;
-    } else {
-        currentEditIndex = row;
-    }
+    currentEditId = idItem ? idItem->data(Qt::UserRole).toULongLong() : 0;
     
-    const auto& contacts = phoneBook.getContacts();
-    if (currentEditIndex >= 0 && currentEditIndex < static_cast<int>(contacts.size())) {
-        populateForm(contacts[currentEditIndex]);
+    if (phoneBook.hasContact(currentEditId)) {
+        populateForm(phoneBook.getContact(currentEditId));
         editButton->setEnabled(true);
         deleteButton->setEnabled(true);
     }
@@ -462,17 +525,10 @@ void MainWindow::populateForm(const Contact& contact) {
     emailEdit->setText(QString::fromUtf8(contact.getEmail().c_str()));
     addressEdit->setText(QString::fromUtf8(contact.getAddress().c_str()));
     
-    QString birthDateStr = QString::fromUtf8(contact.getBirthDate().c_str());
-    if (!birthDateStr.isEmpty()) {
-        QDate date = QDate::fromString(birthDateStr, "yyyy-MM-dd");
-        if (!date.isValid()) {
-            date = QDate::fromString(birthDateStr, "dd-MM-yyyy");
-        }
-        if (date.isValid()) {
-            birthDateEdit->setDate(date);
-        } else {
-            birthDateEdit->setDate(QDate::currentDate());
-        }
+    if (contact.getBirthDay() != BirthDate::none) {
+        int year, month, day;
+        BirthDate::toCivil(contact.getBirthDay(), year, month, day);
+        birthDateEdit->setDate(QDate(year, month, day));
     } else {
         birthDateEdit->setDate(QDate::currentDate());
     }
@@ -573,7 +629,7 @@ void MainWindow::clearForm() {
     birthDateEdit->setDate(QDate::currentDate());
     phonesListWidget->clear();
     phoneNumberEdit->clear();
-    currentEditIndex = -1;
+    currentEditId = 0;
     editButton->setEnabled(false);
     deleteButton->setEnabled(false);
 }
@@ -606,9 +662,20 @@ void MainWindow::loadFromFile() {
     
     if (!filename.isEmpty()) {
         try {
-            phoneBook.loadFromFile(filename.toStdString());
+            LoadStats stats = phoneBook.loadFromFile(filename.toStdString());
             updateTable();
-            showInfo("Контакты загружены из файла: " + filename);
+            QString message = QString("Контакты загружены из файла: %1\nПринято строк: %2 из %3")
+                                  .arg(filename).arg(stats.accepted).arg(stats.rowsRead);
+            for (const auto& rejected : stats.rejected) {
+                message += QString("\nОтклонено %1: %2, %3")
+                               .arg(rejected.second)
+                               .arg(Contact::fieldName(rejected.first.first))
+                               .arg(Validator::errorName(rejected.first.second));
+            }
+            if (stats.phonesSkipped > 0) {
+                message += QString("\nПропущено неверных телефонов: %1").arg(stats.phonesSkipped);
+            }
+            showInfo(message);
         } catch (const std::exception& e) {
             showError(QString("Ошибка при загрузке из файла: %1").arg(e.what()));
         }
@@ -9,6 +9,7 @@ class QLineEdit;
 class QPushButton;
 class QComboBox;
 class QDateEdit;
+class QSpinBox;
 class QListWidget;
 class QMenu;
 class QAction;
@@ -29,6 +30,8 @@ private slots:
     void deleteContact();
     void searchContacts();
     void sortContacts();
+    void showUpcomingBirthdays();
+    void showBornBetween();
     void onTableSelectionChanged();
     void clearForm();
     
@@ -43,6 +46,8 @@ private:
     void setupUI();
     void setupStorageMenu();
     void updateTable();
+    void showContacts(const std::vector<uint64_t>& ids);
+    void addTableRow(const Contact& c);
     void populateForm(const Contact& contact);
     Contact getContactFromForm();
     void showError(const QString& message);
@@ -60,6 +65,11 @@ private:
     QComboBox* sortComboBox;
     QPushButton* sortButton;
     QPushButton* clearButton;
+    QSpinBox* birthdayDaysSpin;
+    QPushButton* birthdaysButton;
+    QDateEdit* bornFromEdit;
+    QDateEdit* bornToEdit;
+    QPushButton* bornBetweenButton;
     
     QLineEdit* firstNameEdit;
     QLineEdit* lastNameEdit;
@@ -82,7 +92,7 @@ private:
     QLabel* statusLabel;
     
     PhoneBook phoneBook;
-    int currentEditIndex;
+    uint64_t currentEditId;
     
     static const QString DEFAULT_FILENAME;
 };
@@ -0,0 +1,73 @@
+#ifndef ORDEREDINDEX_H
+#define ORDEREDINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SortItem;
+
+// Contact ids kept sorted by (key, id), with keys compared as unsigned bytes.
+// Each entry caches the first eight key bytes as a big-endian integer, so most
+// comparisons never touch the key itself.
+// Entries live in sorted blocks of at most maxBlock; a Fenwick tree over the
+// block sizes turns a rank into a block in O(log n), so an insert or erase is
+// O(log n + maxBlock) and rows [offset, offset + count) cost O(log n + count).
+class OrderedIndex {
+public:
+    struct Entry {
+        uint64_t prefix;
+        std::string key;
+        uint64_t id;
+    };
+
+    void insert(const std::string& key, uint64_t id);
+    bool erase(const std::string& key, uint64_t id);
+    // Replaces the contents with (key, id) pairs given in any order.
+    void assign(std::vector<std::string> keys, const std::vector<uint64_t>& ids);
+    // Same as assign, but rows are ordered by rank instead of by key: a
+    // smaller rank must mean a smaller key and equal ranks equal keys.
+    void assignRanked(std::vector<std::string> keys, const std::vector<uint64_t>& ids,
+                      const std::vector<uint32_t>& ranks);
+    void clear();
+    size_t size() const { return count; }
+    // Rank of the first entry whose key is not less than key.
+    size_t lowerBound(const std::string& key) const;
+
+    // Calls fn(id) for ranks [offset, offset + limit) until fn returns false.
+    template <typename Callback>
+    void forEachInRange(size_t offset, size_t limit, Callback fn) const;
+
+private:
+    static const size_t maxBlock = 512;
+
+    std::vector<std::vector<Entry>> blocks;
+    std::vector<size_t> tree;
+    size_t count = 0;
+
+    static uint64_t prefixOf(const std::string& key);
+    static bool less(const Entry& e, uint64_t prefix, const std::string& key, uint64_t id);
+    size_t findBlock(uint64_t prefix, const std::string& key, uint64_t id) const;
+    void fill(const std::vector<SortItem>& items, std::vector<std::string>& keys,
+              const std::vector<uint64_t>& ids);
+    size_t locate(size_t rank, size_t& offset) const;
+    size_t entriesBefore(size_t block) const;
+    void addToTree(size_t block, size_t delta, bool subtract);
+    void rebuildTree();
+};
+
+template <typename Callback>
+void OrderedIndex::forEachInRange(size_t offset, size_t limit, Callback fn) const {
+    if (offset >= count || limit == 0) return;
+
+    size_t pos;
+    size_t b = locate(offset, pos);
+    for (; b < blocks.size(); ++b, pos = 0) {
+        for (; pos < blocks[b].size(); ++pos) {
+            if (!fn(blocks[b][pos].id) || --limit == 0) return;
+        }
+    }
+}
+
+#endif
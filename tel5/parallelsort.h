@@ -0,0 +1,155 @@
+#ifndef PARALLELSORT_H
+#define PARALLELSORT_H
+
+#include "taskpool.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A sort key reduced to its first eight bytes, plus the position of the
+// record it came from for breaking ties on the full key.
+struct SortItem {
+    uint64_t prefix;
+    size_t pos;
+};
+
+// Stable parallel sort of SortItems. MSD radix passes over the prefix bytes
+// split the input into buckets that are sorted as independent pool tasks;
+// a large bucket whose prefixes are all equal is merge sorted in parallel,
+// with tieLess(posA, posB) deciding the order.
+class ParallelSort {
+public:
+    template <typename TieLess>
+    static void sort(std::vector<SortItem>& items, TieLess tieLess,
+                     TaskPool& pool = TaskPool::shared());
+
+private:
+    static const size_t serialCutoff = 1 << 14;
+
+    // Stable scatter of [first, last) by the prefix byte at shift; bounds gets
+    // the 257 bucket offsets. Returns false, leaving the range untouched, when
+    // every item falls into the same bucket.
+    static bool partition(SortItem* first, SortItem* last, SortItem* buffer,
+                          unsigned shift, size_t* bounds, TaskPool& pool);
+    static void copy(const SortItem* first, const SortItem* last, SortItem* out, TaskPool& pool);
+
+    template <typename Less>
+    static void sortRange(SortItem* first, SortItem* last, SortItem* buffer, unsigned byte,
+                          const Less& less, TaskPool& pool, TaskPool::Group& group);
+    template <typename Less>
+    static void mergeSort(SortItem* first, SortItem* last, SortItem* buffer,
+                          const Less& less, TaskPool& pool);
+    template <typename Less>
+    static void merge(const SortItem* a, const SortItem* aEnd, const SortItem* b, const SortItem* bEnd,
+                      SortItem* out, const Less& less, TaskPool& pool, TaskPool::Group& group);
+};
+
+template <typename TieLess>
+void ParallelSort::sort(std::vector<SortItem>& items, TieLess tieLess, TaskPool& pool) {
+    auto less = [&tieLess](const SortItem& a, const SortItem& b) {
+        if (a.prefix != b.prefix) return a.prefix < b.prefix;
+        return tieLess(a.pos, b.pos);
+    };
+    if (items.size() <= serialCutoff || pool.size() == 1) {
+        std::stable_sort(items.begin(), items.end(), less);
+        return;
+    }
+
+    std::vector<SortItem> buffer(items.size());
+    TaskPool::Group group;
+    sortRange(items.data(), items.data() + items.size(), buffer.data(), 0, less, pool, group);
+    pool.wait(group);
+}
+
+template <typename Less>
+void ParallelSort::sortRange(SortItem* first, SortItem* last, SortItem* buffer, unsigned byte,
+                             const Less& less, TaskPool& pool, TaskPool::Group& group) {
+    size_t n = static_cast<size_t>(last - first);
+    if (n <= serialCutoff) {
+        std::stable_sort(first, last, less);
+        return;
+    }
+    if (byte == 8) {
+        mergeSort(first, last, buffer, less, pool);
+        return;
+    }
+
+    size_t bounds[257];
+    if (!partition(first, last, buffer, 56 - 8 * byte, bounds, pool)) {
+        sortRange(first, last, buffer, byte + 1, less, pool, group);
+        return;
+    }
+
+    // Big buckets get a task each; runs of small neighbouring buckets are
+    // sorted together, which is fine because they are already in bucket order.
+    size_t batch = 0;
+    for (size_t b = 0; b < 256; ++b) {
+        size_t lo = bounds[b];
+        size_t hi = bounds[b + 1];
+        if (hi - lo > serialCutoff) {
+            if (batch < lo) {
+                pool.run(group, [=, &less]() { std::stable_sort(first + batch, first + lo, less); });
+            }
+            pool.run(group, [=, &less, &pool, &group]() {
+                sortRange(first + lo, first + hi, buffer + lo, byte + 1, less, pool, group);
+            });
+            batch = hi;
+        } else if (hi - batch > serialCutoff) {
+            pool.run(group, [=, &less]() { std::stable_sort(first + batch, first + hi, less); });
+            batch = hi;
+        }
+    }
+    if (batch < n) {
+        pool.run(group, [=, &less]() { std::stable_sort(first + batch, last, less); });
+    }
+}
+
+template <typename Less>
+void ParallelSort::mergeSort(SortItem* first, SortItem* last, SortItem* buffer,
+                             const Less& less, TaskPool& pool) {
+    size_t n = static_cast<size_t>(last - first);
+    if (n <= serialCutoff) {
+        std::stable_sort(first, last, less);
+        return;
+    }
+
+    SortItem* mid = first + n / 2;
+    TaskPool::Group halves;
+    pool.run(halves, [=, &less, &pool]() { mergeSort(first, mid, buffer, less, pool); });
+    mergeSort(mid, last, buffer + n / 2, less, pool);
+    pool.wait(halves);
+
+    TaskPool::Group merging;
+    merge(first, mid, mid, last, buffer, less, pool, merging);
+    pool.wait(merging);
+    copy(buffer, buffer + n, first, pool);
+}
+
+// Splits the larger input at its middle and the other one at the matching
+// bound, so equal items from a still come before those from b.
+template <typename Less>
+void ParallelSort::merge(const SortItem* a, const SortItem* aEnd, const SortItem* b, const SortItem* bEnd,
+                         SortItem* out, const Less& less, TaskPool& pool, TaskPool::Group& group) {
+    size_t na = static_cast<size_t>(aEnd - a);
+    size_t nb = static_cast<size_t>(bEnd - b);
+    if (na + nb <= serialCutoff) {
+        std::merge(a, aEnd, b, bEnd, out, less);
+        return;
+    }
+
+    const SortItem* aMid;
+    const SortItem* bMid;
+    if (na >= nb) {
+        aMid = a + na / 2;
+        bMid = std::lower_bound(b, bEnd, *aMid, less);
+    } else {
+        bMid = b + nb / 2;
+        aMid = std::upper_bound(a, aEnd, *bMid, less);
+    }
+    SortItem* outMid = out + (aMid - a) + (bMid - b);
+    pool.run(group, [=, &less, &pool, &group]() { merge(a, aMid, b, bMid, out, less, pool, group); });
+    merge(aMid, aEnd, bMid, bEnd, outMid, less, pool, group);
+}
+
+#endif
@@ -1,7 +1,11 @@
 #include "phonebook.h"
+#include "validator.h"
+#include "collation.h"
+#include "taskpool.h"
 #include <algorithm>
 #include <cctype>
 #include <fstream>
+#include <numeric>
 #include <sstream>
 #include <stdexcept>
 #include <iostream>
@@ -26,91 +30,507 @@ void PhoneBook::initializeDatabase(const std::string& dbPath) {
     }
 }
 
-void PhoneBook::addContact(const Contact& contact) {
+uint64_t PhoneBook::addContact(const Contact& contact) {
     contacts.push_back(contact);
+    contacts.back().id = nextId++;
+    index.insert(contacts.back().id, contacts.size() - 1);
+    indexContact(contacts.back());
     syncToDatabase();
+    return contacts.back().id;
 }
 
-void PhoneBook::removeContact(size_t index) {
-    if (index >= contacts.size()) {
-        throw std::out_of_range("Invalid index");
+void PhoneBook::removeContact(uint64_t id) {
+    size_t slot = slotOf(id);
+    unindexContact(contacts[slot]);
+    // The last contact fills the hole; byId keeps the order they were added in.
+    if (slot != contacts.size() - 1) {
+        contacts[slot] = std::move(contacts.back());
+        index.insert(contacts[slot].id, slot);
     }
-    contacts.erase(contacts.begin() + index);
+    contacts.pop_back();
+    index.erase(id);
     syncToDatabase();
 }
 
-void PhoneBook::editContact(size_t index, const Contact& newContact) {
-    if (index >= contacts.size()) {
-        throw std::out_of_range("Invalid index");
-    }
-    contacts[index] = newContact;
+void PhoneBook::editContact(uint64_t id, const Contact& newContact) {
+    size_t slot = slotOf(id);
+    unindexContact(contacts[slot]);
+    contacts[slot] = newContact;
+    contacts[slot].id = id;
+    indexContact(contacts[slot]);
     syncToDatabase();
 }
 
-std::vector<Contact> PhoneBook::search(const std::string& query) const {
-    std::vector<Contact> results;
-    if (query.empty()) {
-        return results;
+const Contact& PhoneBook::getContact(uint64_t id) const {
+    return contacts[slotOf(id)];
+}
+
+size_t PhoneBook::slotOf(uint64_t id) const {
+    size_t slot = index.find(id);
+    if (slot == IdIndex::npos) {
+        throw std::out_of_range("Invalid contact id");
+    }
+    return slot;
+}
+
+void PhoneBook::reindex() {
+    size_t added = 0;
+    for (const auto& c : contacts) {
+        if (c.id == 0) {
+            ++added;
+        }
+    }
+    // Inserting one by one into the ordered indexes only pays off for a few rows.
+    bool bulk = added > 1024;
+
+    index.clear();
+    index.reserve(contacts.size());
+    for (size_t i = 0; i < contacts.size(); ++i) {
+        if (contacts[i].id == 0) {
+            contacts[i].id = nextId++;
+            indexContact(contacts[i], !bulk);
+        }
+        index.insert(contacts[i].id, i);
+    }
+    if (bulk) {
+        rebuildOrderIndexes();
+    }
+}
+
+void PhoneBook::indexContact(const Contact& c, bool withOrder) {
+    trigrams.add(c.id, c.getSearchKey());
+    keys.add(c.id, c.getSearchKey());
+    phoneIndex.add(c.id, c.getPhones());
+    if (!withOrder) {
+        return;
     }
+    byId.insert(std::string(), c.id);
+    for (size_t f = 0; f < sortFieldCount; ++f) {
+        orderIndexes[f].insert(sortKey(c, static_cast<SortField>(f)), c.id);
+    }
+    if (customOrdered()) {
+        customOrder.insert(orderKey(c, order), c.id);
+    }
+    if (c.birthDay != BirthDate::none) {
+        calendar.insert(calendarKey(c.birthDay), c.id);
+    }
+}
 
-    std::string q = query;
-    std::transform(q.begin(), q.end(), q.begin(), ::tolower);
+void PhoneBook::unindexContact(const Contact& c) {
+    trigrams.remove(c.id, c.getSearchKey());
+    keys.remove(c.id);
+    phoneIndex.remove(c.id, c.getPhones());
+    byId.erase(std::string(), c.id);
+    for (size_t f = 0; f < sortFieldCount; ++f) {
+        orderIndexes[f].erase(sortKey(c, static_cast<SortField>(f)), c.id);
+    }
+    if (customOrdered()) {
+        customOrder.erase(orderKey(c, order), c.id);
+    }
+    if (c.birthDay != BirthDate::none) {
+        calendar.erase(calendarKey(c.birthDay), c.id);
+    }
+}
 
+void PhoneBook::rebuildOrderIndexes() {
+    std::vector<uint64_t> ids;
+    ids.reserve(contacts.size());
     for (const auto& c : contacts) {
-        std::string firstName = c.getFirstName();
-        std::string lastName = c.getLastName();
-        std::string email = c.getEmail();
-
-        std::string firstLower = firstName;
-        std::string lastLower = lastName;
-        std::string emailLower = email;
-        
-        std::transform(firstLower.begin(), firstLower.end(), firstLower.begin(), ::tolower);
-        std::transform(lastLower.begin(), lastLower.end(), lastLower.begin(), ::tolower);
-        std::transform(emailLower.begin(), emailLower.end(), emailLower.begin(), ::tolower);
-
-        if (firstLower.find(q) != std::string::npos || 
-            lastLower.find(q) != std::string::npos ||
-            emailLower.find(q) != std::string::npos) {
-            results.push_back(c);
+        ids.push_back(c.id);
+    }
+    // First and middle names are symbols, so their keys and order are worked
+    // out once per distinct name and the contacts are sorted by rank.
+    std::vector<std::string> symbolKeys;
+    std::vector<uint32_t> symbolRanks;
+    symbolOrder(symbolKeys, symbolRanks);
+
+    TaskPool& pool = TaskPool::shared();
+    TaskPool::Group group;
+    for (size_t f = 0; f < sortFieldCount; ++f) {
+        pool.run(group, [this, f, &ids, &symbolKeys, &symbolRanks]() {
+            SortField field = static_cast<SortField>(f);
+            std::vector<std::string> sortKeys;
+            sortKeys.reserve(contacts.size());
+            if (field == SortField::FirstName || field == SortField::MiddleName) {
+                std::vector<uint32_t> ranks;
+                ranks.reserve(contacts.size());
+                for (const auto& c : contacts) {
+                    StringPool::Symbol s = field == SortField::FirstName ? c.firstName : c.middleName;
+                    sortKeys.push_back(symbolKeys[s]);
+                    ranks.push_back(symbolRanks[s]);
+                }
+                orderIndexes[f].assignRanked(std::move(sortKeys), ids, ranks);
+                return;
+            }
+            for (const auto& c : contacts) {
+                sortKeys.push_back(sortKey(c, field));
+            }
+            orderIndexes[f].assign(std::move(sortKeys), ids);
+        });
+    }
+    if (customOrdered()) {
+        pool.run(group, [this, &ids]() {
+            std::vector<std::string> packed;
+            packed.reserve(contacts.size());
+            for (const auto& c : contacts) {
+                packed.push_back(orderKey(c, order));
+            }
+            customOrder.assign(std::move(packed), ids);
+        });
+    }
+    pool.run(group, [this, &ids]() {
+        byId.assign(std::vector<std::string>(ids.size()), ids);
+    });
+    pool.run(group, [this]() {
+        std::vector<std::string> days;
+        std::vector<uint64_t> born;
+        for (const auto& c : contacts) {
+            if (c.birthDay != BirthDate::none) {
+                days.push_back(calendarKey(c.birthDay));
+                born.push_back(c.id);
+            }
         }
+        calendar.assign(std::move(days), born);
+    });
+    pool.wait(group);
+}
+
+// Names and emails are ordered by collation key; yyyy-MM-dd dates already
+// sort correctly as bytes.
+std::string PhoneBook::sortKey(const Contact& c, SortField field) {
+    switch (field) {
+    case SortField::FirstName:
+        return Collation::key(c.getFirstName());
+    case SortField::LastName:
+        return Collation::key(c.getLastName());
+    case SortField::MiddleName:
+        return Collation::key(c.getMiddleName());
+    case SortField::Email: {
+        std::string key = Collation::key(c.emailLocal);
+        Collation::appendKey(key, StringPool::shared().text(c.emailDomain));
+        return key;
     }
-    return results;
+    default:
+        return dayKey(c.birthDay);
+    }
+}
+
+// Collation key and rank of every interned string, by symbol; strings with
+// equal keys share a rank.
+void PhoneBook::symbolOrder(std::vector<std::string>& keys, std::vector<uint32_t>& ranks) {
+    std::vector<std::string_view> texts = StringPool::shared().snapshot();
+    keys.resize(texts.size());
+    for (size_t s = 0; s < texts.size(); ++s) {
+        keys[s] = Collation::key(texts[s]);
+    }
+
+    std::vector<uint32_t> byKey(texts.size());
+    std::iota(byKey.begin(), byKey.end(), 0);
+    std::sort(byKey.begin(), byKey.end(), [&keys](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+    ranks.assign(texts.size(), 0);
+    uint32_t rank = 0;
+    for (size_t i = 0; i < byKey.size(); ++i) {
+        if (i > 0 && keys[byKey[i]] != keys[byKey[i - 1]]) {
+            ++rank;
+        }
+        ranks[byKey[i]] = rank;
+    }
+}
+
+// Big-endian with the sign bit flipped, so byte order is date order and
+// contacts without a date come first.
+std::string PhoneBook::dayKey(int32_t day) {
+    uint32_t v = static_cast<uint32_t>(day) ^ 0x80000000u;
+    std::string key(4, '\0');
+    for (int i = 3; i >= 0; --i, v >>= 8) {
+        key[i] = static_cast<char>(v & 0xFF);
+    }
+    return key;
+}
+
+std::string PhoneBook::calendarKey(int32_t day) {
+    int year, month, dayOfMonth;
+    BirthDate::toCivil(day, year, month, dayOfMonth);
+    return std::string{static_cast<char>(month), static_cast<char>(dayOfMonth)};
+}
+
+// Concatenates the field keys so that one byte comparison orders by every
+// level. 0x00 and 0x01 are escaped and each field ends with 0x00, so a field
+// that is a prefix of another sorts first; a descending field has all of its
+// bytes inverted.
+std::string PhoneBook::orderKey(const Contact& c, const std::vector<OrderKey>& keys) {
+    std::string packed;
+    for (const auto& k : keys) {
+        size_t start = packed.size();
+        for (char ch : sortKey(c, k.field)) {
+            unsigned char b = static_cast<unsigned char>(ch);
+            if (b <= 0x01) {
+                packed += '\x01';
+                packed += static_cast<char>(b + 1);
+            } else {
+                packed += ch;
+            }
+        }
+        packed += '\0';
+        if (k.descending) {
+            for (size_t i = start; i < packed.size(); ++i) {
+                packed[i] = static_cast<char>(~packed[i]);
+            }
+        }
+    }
+    return packed;
+}
+
+const OrderedIndex& PhoneBook::currentOrder() const {
+    if (order.empty()) {
+        return byId;
+    }
+    if (customOrdered()) {
+        return customOrder;
+    }
+    return orderIndexes[static_cast<size_t>(order[0].field)];
+}
+
+void PhoneBook::clearIndexes() {
+    index.clear();
+    trigrams.clear();
+    keys.clear();
+    phoneIndex.clear();
+    byId.clear();
+    for (auto& orderIndex : orderIndexes) {
+        orderIndex.clear();
+    }
+    customOrder.clear();
+    calendar.clear();
+}
+
+std::vector<SearchHit> PhoneBook::search(const std::string& query, size_t offset, size_t limit) const {
+    std::vector<SearchHit> hits;
+    if (limit == 0) {
+        return hits;
+    }
+
+    size_t skipped = 0;
+    forEachMatch(query, [&](const Contact&, const SearchHit& hit) {
+        if (skipped < offset) {
+            ++skipped;
+            return true;
+        }
+        hits.push_back(hit);
+        return hits.size() < limit;
+    });
+    return hits;
+}
+
+const Contact* PhoneBook::findByPhone(const std::string& number) const {
+    return findByPhoneKey(Validator::phoneKey(number));
+}
+
+const Contact* PhoneBook::findByPhoneKey(uint64_t key) const {
+    uint64_t id = phoneIndex.findFirst(key);
+    return id == 0 ? nullptr : &contacts[index.find(id)];
 }
 
-bool PhoneBook::sortByField(const std::string& field) {
-    std::string f = field;
+std::vector<uint64_t> PhoneBook::findAllByPhone(const std::string& number) const {
+    return phoneIndex.findAll(Validator::phoneKey(number));
+}
+
+bool PhoneBook::parseSortField(const std::string& name, SortField& field) {
+    std::string f = name;
     std::transform(f.begin(), f.end(), f.begin(), ::tolower);
 
     if (f == "name" || f == "firstname" || f == "first") {
-        std::sort(contacts.begin(), contacts.end(), 
-            [](const Contact& a, const Contact& b) {
-                return a.getFirstName() < b.getFirstName();
-            });
-        return true;
+        field = SortField::FirstName;
+    } else if (f == "last" || f == "lastname" || f == "surname") {
+        field = SortField::LastName;
+    } else if (f == "middle" || f == "middlename" || f == "patronymic") {
+        field = SortField::MiddleName;
+    } else if (f == "email") {
+        field = SortField::Email;
+    } else if (f == "birthdate" || f == "date") {
+        field = SortField::BirthDate;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool PhoneBook::parseOrder(const std::string& spec, std::vector<OrderKey>& keys) {
+    std::vector<OrderKey> parsed;
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        item = Validator::trim(item);
+        OrderKey key{SortField::LastName, false};
+        if (!item.empty() && (item[0] == '-' || item[0] == '+')) {
+            key.descending = item[0] == '-';
+            item.erase(0, 1);
+        }
+        if (!parseSortField(item, key.field)) {
+            return false;
+        }
+        parsed.push_back(key);
     }
-    else if (f == "last" || f == "lastname" || f == "surname") {
-        std::sort(contacts.begin(), contacts.end(), 
-            [](const Contact& a, const Contact& b) {
-                return a.getLastName() < b.getLastName();
-            });
+    if (parsed.empty()) {
+        return false;
+    }
+    keys = std::move(parsed);
+    return true;
+}
+
+bool PhoneBook::sortByField(const std::string& spec) {
+    std::vector<OrderKey> keys;
+    if (!parseOrder(spec, keys)) {
+        return false;
+    }
+    return sortBy(keys);
+}
+
+bool PhoneBook::sortBy(const std::vector<OrderKey>& keys) {
+    if (keys.empty()) {
+        return false;
+    }
+    order = keys;
+    if (!customOrdered()) {
+        customOrder.clear();
         return true;
     }
-    else if (f == "email") {
-        std::sort(contacts.begin(), contacts.end(), 
-            [](const Contact& a, const Contact& b) {
-                return a.getEmail() < b.getEmail();
-            });
+
+    std::vector<std::string> packed;
+    std::vector<uint64_t> ids;
+    packed.reserve(contacts.size());
+    ids.reserve(contacts.size());
+    for (const auto& c : contacts) {
+        packed.push_back(orderKey(c, order));
+        ids.push_back(c.id);
+    }
+    customOrder.assign(std::move(packed), ids);
+    return true;
+}
+
+std::vector<uint64_t> PhoneBook::orderedRange(SortField field, size_t offset, size_t count) const {
+    std::vector<uint64_t> ids;
+    orderIndexes[static_cast<size_t>(field)].forEachInRange(offset, count, [&ids](uint64_t id) {
+        ids.push_back(id);
         return true;
+    });
+    return ids;
+}
+
+std::vector<uint64_t> PhoneBook::orderedRange(const std::vector<OrderKey>& keys,
+                                              size_t offset, size_t count) const {
+    if (keys.size() == 1 && !keys[0].descending) {
+        return orderedRange(keys[0].field, offset, count);
+    }
+    bool sameAsCurrent = keys.size() == order.size() && customOrdered() &&
+        std::equal(keys.begin(), keys.end(), order.begin(), [](const OrderKey& a, const OrderKey& b) {
+            return a.field == b.field && a.descending == b.descending;
+        });
+    if (sameAsCurrent) {
+        return currentRange(offset, count);
+    }
+    return selectRange(keys, offset, count);
+}
+
+std::vector<uint64_t> PhoneBook::upcomingBirthdays(int days, int32_t from) const {
+    std::vector<uint64_t> ids;
+    if (days <= 0) {
+        return ids;
+    }
+
+    size_t first = calendar.lowerBound(calendarKey(from));
+    if (days >= 366) {
+        // A whole year: every birthday once, starting from today's.
+        ids = idsInRange(calendar, first, calendar.size());
+        std::vector<uint64_t> wrapped = idsInRange(calendar, 0, first);
+        ids.insert(ids.end(), wrapped.begin(), wrapped.end());
+        return ids;
     }
-    else if (f == "birthdate" || f == "date") {
-        std::sort(contacts.begin(), contacts.end(), 
-            [](const Contact& a, const Contact& b) {
-                return a.getBirthDate() < b.getBirthDate();
-            });
+
+    int fromYear, lastYear, month, day;
+    BirthDate::toCivil(from, fromYear, month, day);
+    BirthDate::toCivil(from + days - 1, lastYear, month, day);
+    // The day after the last one; day 32 sorts before the next month.
+    size_t last = calendar.lowerBound(std::string{static_cast<char>(month), static_cast<char>(day + 1)});
+    if (lastYear == fromYear) {
+        return idsInRange(calendar, first, last);
+    }
+    ids = idsInRange(calendar, first, calendar.size());
+    std::vector<uint64_t> wrapped = idsInRange(calendar, 0, last);
+    ids.insert(ids.end(), wrapped.begin(), wrapped.end());
+    return ids;
+}
+
+std::vector<uint64_t> PhoneBook::bornBetween(int32_t from, int32_t to) const {
+    if (from == BirthDate::none || to == BirthDate::none || to < from) {
+        return std::vector<uint64_t>();
+    }
+    const OrderedIndex& byDate = orderIndexes[static_cast<size_t>(SortField::BirthDate)];
+    return idsInRange(byDate, byDate.lowerBound(dayKey(from)), byDate.lowerBound(dayKey(to + 1)));
+}
+
+std::vector<uint64_t> PhoneBook::idsInRange(const OrderedIndex& ordered, size_t first, size_t last) const {
+    std::vector<uint64_t> ids;
+    if (first >= last) {
+        return ids;
+    }
+    ids.reserve(last - first);
+    ordered.forEachInRange(first, last - first, [&ids](uint64_t id) {
+        ids.push_back(id);
         return true;
+    });
+    return ids;
+}
+
+std::vector<uint64_t> PhoneBook::currentRange(size_t offset, size_t count) const {
+    std::vector<uint64_t> ids;
+    currentOrder().forEachInRange(offset, count, [&ids](uint64_t id) {
+        ids.push_back(id);
+        return true;
+    });
+    return ids;
+}
+
+// Keeps the best offset + count rows in a max-heap while scanning, or, when
+// the page reaches far into the book, selects it with nth_element.
+std::vector<uint64_t> PhoneBook::selectRange(const std::vector<OrderKey>& keys,
+                                             size_t offset, size_t count) const {
+    std::vector<uint64_t> ids;
+    if (offset >= contacts.size() || count == 0) {
+        return ids;
+    }
+    size_t end = offset + std::min(count, contacts.size() - offset);
+
+    typedef std::pair<std::string, uint64_t> Ranked;
+    std::vector<Ranked> rows;
+    if (end <= contacts.size() / 8) {
+        rows.reserve(end + 1);
+        for (const auto& c : contacts) {
+            Ranked row(orderKey(c, keys), c.id);
+            if (rows.size() == end && !(row < rows.front())) {
+                continue;
+            }
+            rows.push_back(std::move(row));
+            std::push_heap(rows.begin(), rows.end());
+            if (rows.size() > end) {
+                std::pop_heap(rows.begin(), rows.end());
+                rows.pop_back();
+            }
+        }
+        std::sort_heap(rows.begin(), rows.end());
+    } else {
+        rows.reserve(contacts.size());
+        for (const auto& c : contacts) {
+            rows.emplace_back(orderKey(c, keys), c.id);
+        }
+        std::nth_element(rows.begin(), rows.begin() + offset, rows.end());
+        std::partial_sort(rows.begin() + offset, rows.begin() + end, rows.end());
+    }
+
+    for (size_t i = offset; i < end; ++i) {
+        ids.push_back(rows[i].second);
     }
-    return false;
+    return ids;
 }
 
 void PhoneBook::saveToFile(const std::string& filename) const {
@@ -119,49 +539,107 @@ void PhoneBook::saveToFile(const std::string& filename) const {
         throw std::runtime_error("Cannot open file for writing");
     }
     
-    for (const auto& c : contacts) {
-        file << c.toString() << "\n";
-    }
+    byId.forEachInRange(0, contacts.size(), [&](uint64_t id) {
+        file << contacts[index.find(id)].toString() << "\n";
+        return true;
+    });
     
     syncToDatabase();
 }
 
-void PhoneBook::loadFromFile(const std::string& filename) {
+LoadStats PhoneBook::loadFromFile(const std::string& filename, LoadMode mode) {
+    LoadStats stats;
     std::ifstream file(filename);
     if (!file) {
-        return;
+        return stats;
     }
     
     contacts.clear();
+    arena.release();
+    clearIndexes();
     std::string line;
     while (std::getline(file, line)) {
         if (line.empty()) continue;
-        try {
-            contacts.push_back(Contact::fromString(line));
-        } catch (...) {
-    
+        ++stats.rowsRead;
+        ParseResult parsed = mode == LoadMode::Validate ? Contact::tryParse(line, &arena)
+                                                        : Contact::parseTrusted(line, &arena);
+        if (!parsed) {
+            ++stats.rejected[{parsed.field, parsed.error}];
+            continue;
         }
+        contacts.push_back(std::move(*parsed.contact));
+        ++stats.accepted;
+        stats.phonesSkipped += parsed.skippedPhones;
     }
+    if (mode == LoadMode::Verify) {
+        verifyFrom(0, stats);
+    }
+    reindex();
     
     syncToDatabase();
+    return stats;
+}
+
+// Checks contacts[first..] in parallel and drops the ones that fail.
+void PhoneBook::verifyFrom(size_t first, LoadStats& stats) {
+    const size_t n = contacts.size() - first;
+    std::vector<std::pair<ContactField, ValidationError>> results(n, {ContactField::Record, ValidationError::None});
+    TaskPool& pool = TaskPool::shared();
+    TaskPool::Group group;
+    for (size_t begin = 0; begin < n; begin += 4096) {
+        size_t end = std::min(n, begin + 4096);
+        pool.run(group, [this, first, begin, end, &results]() {
+            for (size_t i = begin; i < end; ++i) {
+                results[i].second = contacts[first + i].verify(results[i].first);
+            }
+        });
+    }
+    pool.wait(group);
+
+    size_t kept = first;
+    for (size_t i = 0; i < n; ++i) {
+        if (results[i].second != ValidationError::None) {
+            ++stats.rejected[results[i]];
+            --stats.accepted;
+            continue;
+        }
+        if (kept != first + i) {
+            contacts[kept] = std::move(contacts[first + i]);
+        }
+        ++kept;
+    }
+    contacts.erase(contacts.begin() + kept, contacts.end());
 }
 
 void PhoneBook::saveToDatabase() const {
     syncToDatabase();
 }
 
-void PhoneBook::loadFromDatabase() {
+LoadStats PhoneBook::loadFromDatabase(bool verify) {
+    LoadStats stats;
     if (!database || !database->isOpen()) {
         initializeDatabase(dbPath);
     }
     
     if (database && database->isOpen()) {
-        contacts = database->getAllContacts();
+        contacts.clear();
+        arena.release();
+        contacts = database->getAllContacts(&arena);
+        stats.rowsRead = contacts.size();
+        stats.accepted = contacts.size();
+        if (verify) {
+            verifyFrom(0, stats);
+        }
+        clearIndexes();
+        reindex();
     }
+    return stats;
 }
 
 void PhoneBook::clearAllContacts() {
     contacts.clear();
+    arena.release();
+    clearIndexes();
     if (database && database->isOpen()) {
         database->clearAll();
     }
@@ -173,7 +651,8 @@ void PhoneBook::syncToDatabase() const {
     }
     
     database->clearAll();
-    for (const auto& contact : contacts) {
-        database->addContact(contact);
-    }
+    byId.forEachInRange(0, contacts.size(), [this](uint64_t id) {
+        database->addContact(contacts[index.find(id)]);
+        return true;
+    });
 }
@@ -77,12 +77,12 @@ bool PhoneBookDatabase::addContact(const Contact& contact) {
         "VALUES (:first_name, :last_name, :middle_name, :address, :birth_date, :email)"
     );
     
-    query.bindValue(":first_name", QString::fromStdString(contact.getFirstName()));
-    query.bindValue(":last_name", QString::fromStdString(contact.getLastName()));
-    query.bindValue(":middle_name", QString::fromStdString(contact.getMiddleName()));
-    query.bindValue(":address", QString::fromStdString(contact.getAddress()));
-    query.bindValue(":birth_date", QString::fromStdString(contact.getBirthDate()));
-    query.bindValue(":email", QString::fromStdString(contact.getEmail()));
+    query.bindValue(":first_name", QString::fromUtf8(contact.getFirstName().c_str()));
+    query.bindValue(":last_name", QString::fromUtf8(contact.getLastName().c_str()));
+    query.bindValue(":middle_name", QString::fromUtf8(contact.getMiddleName().c_str()));
+    query.bindValue(":address", QString::fromUtf8(contact.getAddress().c_str()));
+    query.bindValue(":birth_date", QString::fromUtf8(contact.getBirthDate().c_str()));
+    query.bindValue(":email", QString::fromUtf8(contact.getEmail().c_str()));
     
     if (!query.exec()) {
         qDebug() << "Error adding contact:" << query.lastError().text();
@@ -119,12 +119,12 @@ bool PhoneBookDatabase::updateContact(size_t id, const Contact& contact) {
     );
     
     query.bindValue(":id", static_cast<qulonglong>(id));
-    query.bindValue(":first_name", QString::fromStdString(contact.getFirstName()));
-    query.bindValue(":last_name", QString::fromStdString(contact.getLastName()));
-    query.bindValue(":middle_name", QString::fromStdString(contact.getMiddleName()));
-    query.bindValue(":address", QString::fromStdString(contact.getAddress()));
-    query.bindValue(":birth_date", QString::fromStdString(contact.getBirthDate()));
-    query.bindValue(":email", QString::fromStdString(contact.getEmail()));
+    query.bindValue(":first_name", QString::fromUtf8(contact.getFirstName().c_str()));
+    query.bindValue(":last_name", QString::fromUtf8(contact.getLastName().c_str()));
+    query.bindValue(":middle_name", QString::fromUtf8(contact.getMiddleName().c_str()));
+    query.bindValue(":address", QString::fromUtf8(contact.getAddress().c_str()));
+    query.bindValue(":birth_date", QString::fromUtf8(contact.getBirthDate().c_str()));
+    query.bindValue(":email", QString::fromUtf8(contact.getEmail().c_str()));
     
     if (!query.exec()) {
         qDebug() << "Error updating contact:" << query.lastError().text();
@@ -135,7 +135,7 @@ bool PhoneBookDatabase::updateContact(size_t id, const Contact& contact) {
     return addPhoneNumbers(id, contact.getPhones());
 }
 
-std::vector<Contact> PhoneBookDatabase::getAllContacts() const {
+std::vector<Contact> PhoneBookDatabase::getAllContacts(std::pmr::memory_resource* resource) const {
     std::vector<Contact> contacts;
     if (!db.isOpen()) return contacts;
     
@@ -145,32 +145,27 @@ std::vector<Contact> PhoneBookDatabase::getAllContacts() const {
         return contacts;
     }
     
+    // Rows were validated before they were written, so they are moved into
+    // contacts as they are; PhoneBook::loadFromDatabase(true) re-checks them.
     while (query.next()) {
         size_t id = query.value(0).toULongLong();
+        ContactFields fields(resource);
         std::string firstName = query.value(1).toString().toStdString();
-        std::string lastName = query.value(2).toString().toStdString();
         std::string middleName = query.value(3).toString().toStdString();
         std::string address = query.value(4).toString().toStdString();
-        std::string birthDate = query.value(5).toString().toStdString();
         std::string email = query.value(6).toString().toStdString();
-
-        std::vector<PhoneNumber> phones = getPhoneNumbers(id);
-
-        PhoneNumber firstPhone = phones.empty() ? 
-            PhoneNumber(PhoneType::Work, "000") : phones[0];
-        
-        Contact contact(firstName, lastName, email, firstPhone);
-        contact.setMiddleName(middleName);
-        contact.setAddress(address);
-        contact.setBirthDate(birthDate);
-        
-        if (!phones.empty() && phones.size() > 1) {
-            for (size_t i = 1; i < phones.size(); ++i) {
-                contact.addPhone(phones[i]);
-            }
+        fields.firstName = firstName;
+        fields.lastName = query.value(2).toString().toStdString();
+        fields.middleName = middleName;
+        fields.address = address;
+        std::string birthDate = query.value(5).toString().toStdString();
+        if (!birthDate.empty()) {
+            fields.birthDay = BirthDate::parse(birthDate);
         }
-        
-        contacts.push_back(contact);
+        fields.email = email;
+        getPhoneNumbers(id, fields.phones);
+
+        contacts.push_back(Contact::trusted(std::move(fields)));
     }
     
     return contacts;
@@ -189,30 +184,23 @@ Contact PhoneBookDatabase::getContactById(size_t id) const {
         throw std::runtime_error("Contact not found");
     }
     
+    ContactFields fields;
     std::string firstName = query.value(0).toString().toStdString();
-    std::string lastName = query.value(1).toString().toStdString();
     std::string middleName = query.value(2).toString().toStdString();
     std::string address = query.value(3).toString().toStdString();
-    std::string birthDate = query.value(4).toString().toStdString();
     std::string email = query.value(5).toString().toStdString();
-    
-    std::vector<PhoneNumber> phones = getPhoneNumbers(id);
-    
-    PhoneNumber firstPhone = phones.empty() ? 
-        PhoneNumber(PhoneType::Work, "000") : phones[0];
-    
-    Contact contact(firstName, lastName, email, firstPhone);
-    contact.setMiddleName(middleName);
-    contact.setAddress(address);
-    contact.setBirthDate(birthDate);
-    
-    if (!phones.empty() && phones.size() > 1) {
-        for (size_t i = 1; i < phones.size(); ++i) {
-            contact.addPhone(phones[i]);
-        }
+    fields.firstName = firstName;
+    fields.lastName = query.value(1).toString().toStdString();
+    fields.middleName = middleName;
+    fields.address = address;
+    std::string birthDate = query.value(4).toString().toStdString();
+    if (!birthDate.empty()) {
+        fields.birthDay = BirthDate::parse(birthDate);
     }
-    
-    return contact;
+    fields.email = email;
+    getPhoneNumbers(id, fields.phones);
+
+    return Contact::trusted(std::move(fields));
 }
 
 bool PhoneBookDatabase::clearAll() {
@@ -229,7 +217,7 @@ bool PhoneBookDatabase::isOpen() const {
     return db.isOpen();
 }
 
-bool PhoneBookDatabase::addPhoneNumbers(size_t contactId, const std::vector<PhoneNumber>& phones) {
+bool PhoneBookDatabase::addPhoneNumbers(size_t contactId, const std::pmr::vector<PhoneNumber>& phones) {
     if (!db.isOpen()) return false;
     
     QSqlQuery query(db);
@@ -259,9 +247,8 @@ bool PhoneBookDatabase::removePhoneNumbers(size_t contactId) {
     return query.exec();
 }
 
-std::vector<PhoneNumber> PhoneBookDatabase::getPhoneNumbers(size_t contactId) const {
-    std::vector<PhoneNumber> phones;
-    if (!db.isOpen()) return phones;
+void PhoneBookDatabase::getPhoneNumbers(size_t contactId, std::pmr::vector<PhoneNumber>& phones) const {
+    if (!db.isOpen()) return;
     
     QSqlQuery query(db);
     query.prepare("SELECT type, number FROM phone_numbers WHERE contact_id = :contact_id");
@@ -269,15 +256,16 @@ std::vector<PhoneNumber> PhoneBookDatabase::getPhoneNumbers(size_t contactId) co
     
     if (!query.exec()) {
         qDebug() << "Error getting phone numbers:" << query.lastError().text();
-        return phones;
+        return;
     }
     
     while (query.next()) {
         int type = query.value(0).toInt();
         std::string number = query.value(1).toString().toStdString();
-        phones.push_back(PhoneNumber(static_cast<PhoneType>(type), number));
+        PhoneNumber phone = PhoneNumber::trusted(static_cast<PhoneType>(type), number);
+        if (type >= 0 && type <= static_cast<int>(PhoneType::Office) && phone.getKey() != 0) {
+            phones.push_back(phone);
+        }
     }
-    
-    return phones;
 }
 
@@ -6,6 +6,7 @@
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
@@ -20,7 +21,8 @@ public:
     bool addContact(const Contact& contact);
     bool removeContact(size_t id);
     bool updateContact(size_t id, const Contact& contact);
-    std::vector<Contact> getAllContacts() const;
+    // Contacts' strings and phone lists are allocated from resource.
+    std::vector<Contact> getAllContacts(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
     Contact getContactById(size_t id) const;
     
     bool clearAll();
@@ -30,9 +32,10 @@ public:
 private:
     QSqlDatabase db;
     bool createTables();
-    bool addPhoneNumbers(size_t contactId, const std::vector<PhoneNumber>& phones);
+    bool addPhoneNumbers(size_t contactId, const std::pmr::vector<PhoneNumber>& phones);
     bool removePhoneNumbers(size_t contactId);
-    std::vector<PhoneNumber> getPhoneNumbers(size_t contactId) const;
+    // Appends the contact's numbers to phones.
+    void getPhoneNumbers(size_t contactId, std::pmr::vector<PhoneNumber>& phones) const;
 };
 
 #endif
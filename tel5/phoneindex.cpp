@@ -0,0 +1,78 @@
+#include "phoneindex.h"
+
+void PhoneIndex::add(uint64_t id, const std::pmr::vector<PhoneNumber>& phones) {
+    for (const auto& p : phones) {
+        uint64_t key = p.getKey();
+        if (key != 0) insert(key, id);
+    }
+}
+
+void PhoneIndex::remove(uint64_t id, const std::pmr::vector<PhoneNumber>& phones) {
+    for (const auto& p : phones) {
+        uint64_t key = p.getKey();
+        if (key != 0) erase(key, id);
+    }
+}
+
+void PhoneIndex::clear() {
+    heads.clear();
+    entries.clear();
+    freeList = none;
+}
+
+uint64_t PhoneIndex::findFirst(uint64_t key) const {
+    size_t head = heads.find(key);
+    return head == IdIndex::npos ? 0 : entries[head].id;
+}
+
+std::vector<uint64_t> PhoneIndex::findAll(uint64_t key) const {
+    std::vector<uint64_t> ids;
+    size_t head = heads.find(key);
+    if (head == IdIndex::npos) return ids;
+    for (uint32_t i = static_cast<uint32_t>(head); i != none; i = entries[i].next) {
+        ids.push_back(entries[i].id);
+    }
+    return ids;
+}
+
+void PhoneIndex::insert(uint64_t key, uint64_t id) {
+    size_t head = heads.find(key);
+    uint32_t next = head == IdIndex::npos ? none : static_cast<uint32_t>(head);
+    // A contact that lists the same number twice owns it once.
+    for (uint32_t i = next; i != none; i = entries[i].next) {
+        if (entries[i].id == id) return;
+    }
+
+    uint32_t i;
+    if (freeList != none) {
+        i = freeList;
+        freeList = entries[i].next;
+        entries[i] = Entry{id, next};
+    } else {
+        i = static_cast<uint32_t>(entries.size());
+        entries.push_back(Entry{id, next});
+    }
+    heads.insert(key, i);
+}
+
+void PhoneIndex::erase(uint64_t key, uint64_t id) {
+    size_t head = heads.find(key);
+    if (head == IdIndex::npos) return;
+
+    uint32_t prev = none;
+    for (uint32_t i = static_cast<uint32_t>(head); i != none; prev = i, i = entries[i].next) {
+        if (entries[i].id != id) continue;
+
+        uint32_t next = entries[i].next;
+        if (prev != none) {
+            entries[prev].next = next;
+        } else if (next != none) {
+            heads.insert(key, next);
+        } else {
+            heads.erase(key);
+        }
+        entries[i].next = freeList;
+        freeList = i;
+        return;
+    }
+}
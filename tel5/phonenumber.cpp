@@ -3,10 +3,28 @@
 #include "validator.h"
 #include <stdexcept>
 
-PhoneNumber::PhoneNumber(PhoneType type, const std::string& number)
-    : type(type), number(Validator::trim(number))
-{
-    if (!Validator::validatePhone(this->number))
+static uint64_t pack(PhoneType type, uint64_t key) {
+    return key << 8 | (static_cast<uint64_t>(type) & 0xFF);
+}
+
+PhoneNumber::PhoneNumber(PhoneType type, const std::string& number) {
+    uint64_t key;
+    if (Validator::checkPhone(number, key) != ValidationError::None) {
         throw std::invalid_argument("Invalid phone number");
+    }
+    packed = pack(type, key);
+}
+
+PhoneNumber PhoneNumber::trusted(PhoneType type, std::string_view number) {
+    PhoneNumber phone;
+    phone.packed = pack(type, Validator::phoneKey(number));
+    return phone;
+}
+
+std::string PhoneNumber::getNumber() const {
+    return Validator::formatPhone(getKey());
+}
 
+PhoneRegion PhoneNumber::region() const {
+    return NumberingPlan::shared().find(getKey());
 }
@@ -2,20 +2,52 @@
 #ifndef PHONENUMBER_H
 #define PHONENUMBER_H
 
+#include "numberingplan.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
 
 enum class PhoneType { Work, Home, Office };
 
+// A number is kept as its canonical key (the E.164 digits as an integer, see
+// Validator::phoneKey) shifted left by eight bits with the type in the low
+// byte, so a phone is one integer: comparing, hashing and sorting never touch
+// text, and numbers typed as 8..., +7... or with separators are the same
+// phone. The text is rebuilt on demand by getNumber().
 class PhoneNumber {
 public:
     PhoneNumber(PhoneType type, const std::string& number);
-    PhoneType getType() const { return type; }
-    std::string getNumber() const { return number; }
+    // For a number that was validated before it was stored: no checks.
+    static PhoneNumber trusted(PhoneType type, std::string_view number);
+    PhoneType getType() const { return static_cast<PhoneType>(packed & 0xFF); }
+    // Canonical key, 0 if a trusted number did not parse.
+    uint64_t getKey() const { return packed >> 8; }
+    // Validator::formatPhone of the key.
+    std::string getNumber() const;
+    // Operator and region from NumberingPlan::shared().
+    PhoneRegion region() const;
+
+    bool operator==(const PhoneNumber& other) const { return packed == other.packed; }
+    bool operator!=(const PhoneNumber& other) const { return packed != other.packed; }
+    // By number, then by type.
+    bool operator<(const PhoneNumber& other) const { return packed < other.packed; }
 
 private:
-    PhoneType type;
-    std::string number;
+    friend struct std::hash<PhoneNumber>;
+    PhoneNumber() = default;
+
+    uint64_t packed;
 };
 
+namespace std {
+template <>
+struct hash<PhoneNumber> {
+    size_t operator()(const PhoneNumber& phone) const noexcept {
+        return hash<uint64_t>()(phone.packed);
+    }
+};
+}
 
 #endif
@@ -0,0 +1,112 @@
+#include "stringpool.h"
+#include <stdexcept>
+
+#if defined(__GNUC__) || defined(__clang__)
+static unsigned highestBit(uint64_t v) { return 63u - static_cast<unsigned>(__builtin_clzll(v)); }
+#else
+#include <intrin.h>
+static unsigned highestBit(uint64_t v) {
+    unsigned long i;
+    if (_BitScanReverse(&i, static_cast<unsigned long>(v >> 32))) {
+        return static_cast<unsigned>(i) + 32;
+    }
+    _BitScanReverse(&i, static_cast<unsigned long>(v));
+    return static_cast<unsigned>(i);
+}
+#endif
+
+StringPool::StringPool() : count(1) {
+    for (auto& chunk : chunks) {
+        chunk.store(nullptr, std::memory_order_relaxed);
+    }
+    slot(0);
+}
+
+StringPool::~StringPool() {
+    for (auto& chunk : chunks) {
+        delete[] chunk.load(std::memory_order_relaxed);
+    }
+}
+
+// Symbol s lives at position s + 2^firstChunkBits of a sequence cut into
+// chunks of doubling size, so its chunk is the position's highest bit.
+std::string& StringPool::slot(Symbol symbol) const {
+    uint64_t position = static_cast<uint64_t>(symbol) + (uint64_t(1) << firstChunkBits);
+    unsigned c = highestBit(position) - firstChunkBits;
+    size_t offset = static_cast<size_t>(position - (uint64_t(1) << (c + firstChunkBits)));
+    std::string* chunk = chunks[c].load(std::memory_order_acquire);
+    if (!chunk) {
+        std::string* fresh = new std::string[size_t(1) << (c + firstChunkBits)];
+        if (chunks[c].compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel)) {
+            chunk = fresh;
+        } else {
+            delete[] fresh;
+        }
+    }
+    return chunk[offset];
+}
+
+StringPool::Symbol StringPool::intern(std::string_view text) {
+    if (text.empty()) {
+        return 0;
+    }
+    size_t hash = std::hash<std::string_view>()(text);
+    Shard& shard = shards[hash >> (sizeof(size_t) * 8 - shardBits)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.symbols.find(text);
+    if (it != shard.symbols.end()) {
+        return it->second;
+    }
+
+    Symbol symbol = count.fetch_add(1, std::memory_order_acq_rel);
+    if (symbol == UINT32_MAX) {
+        count.fetch_sub(1, std::memory_order_relaxed);
+        throw std::length_error("StringPool is full");
+    }
+    std::string& stored = slot(symbol);
+    stored.assign(text.data(), text.size());
+    shard.symbols.emplace(std::string_view(stored), symbol);
+    return symbol;
+}
+
+bool StringPool::find(std::string_view text, Symbol& symbol) const {
+    if (text.empty()) {
+        symbol = 0;
+        return true;
+    }
+    size_t hash = std::hash<std::string_view>()(text);
+    const Shard& shard = shards[hash >> (sizeof(size_t) * 8 - shardBits)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.symbols.find(text);
+    if (it == shard.symbols.end()) {
+        return false;
+    }
+    symbol = it->second;
+    return true;
+}
+
+const std::string& StringPool::text(Symbol symbol) const {
+    return slot(symbol);
+}
+
+std::vector<std::string_view> StringPool::snapshot() const {
+    // Every intern stores its string while holding its shard, so with all
+    // shards held each symbol below count is complete.
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(shardCount);
+    for (const auto& shard : shards) {
+        locks.emplace_back(shard.mutex);
+    }
+    size_t n = count.load(std::memory_order_acquire);
+    std::vector<std::string_view> texts;
+    texts.reserve(n);
+    for (size_t s = 0; s < n; ++s) {
+        texts.push_back(slot(static_cast<Symbol>(s)));
+    }
+    return texts;
+}
+
+StringPool& StringPool::shared() {
+    static StringPool pool;
+    return pool;
+}
@@ -0,0 +1,61 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Hash-consed strings for fields that repeat a lot: first and middle names,
+// addresses, email domains. intern() hands out a 32-bit symbol that keeps
+// naming the same text for the life of the pool, so two texts are equal
+// exactly when their symbols are. Symbols are dense and 0 is the empty string.
+// Interning locks one of several shards picked by the hash; text() takes no
+// lock, since a string is stored before its symbol is handed out.
+class StringPool {
+public:
+    typedef uint32_t Symbol;
+
+    StringPool();
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+    ~StringPool();
+
+    Symbol intern(std::string_view text);
+    // Looks text up without adding it.
+    bool find(std::string_view text, Symbol& symbol) const;
+    const std::string& text(Symbol symbol) const;
+    // Symbols run from 0 to size() - 1.
+    size_t size() const { return count.load(std::memory_order_acquire); }
+    // The text of every symbol, indexed by symbol. Waits for interns that
+    // are in progress.
+    std::vector<std::string_view> snapshot() const;
+
+    // The pool Contact interns its fields in.
+    static StringPool& shared();
+
+private:
+    static const unsigned shardBits = 4;
+    static const unsigned shardCount = 1u << shardBits;
+    // Chunk c holds 2^(c + firstChunkBits) strings, so 23 chunks cover every
+    // 32-bit symbol and a small pool allocates only the first one.
+    static const unsigned firstChunkBits = 10;
+    static const unsigned chunkCount = 33 - firstChunkBits;
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string_view, Symbol> symbols;
+    };
+
+    Shard shards[shardCount];
+    mutable std::atomic<std::string*> chunks[chunkCount];
+    std::atomic<uint32_t> count;
+
+    std::string& slot(Symbol symbol) const;
+};
+
+#endif
@@ -0,0 +1,137 @@
+#include "substringscan.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SUBSTRINGSCAN_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SUBSTRINGSCAN_AVX2 __attribute__((target("avx2")))
+static unsigned lowestBit(unsigned mask) { return static_cast<unsigned>(__builtin_ctz(mask)); }
+#else
+#define SUBSTRINGSCAN_AVX2
+static unsigned lowestBit(unsigned mask) {
+    unsigned long i;
+    _BitScanForward(&i, mask);
+    return static_cast<unsigned>(i);
+}
+#endif
+
+typedef const char* (*FindFunction)(const char*, const char*, const char*, size_t);
+
+static const char* findScalar(const char* first, const char* last, const char* needle, size_t n) {
+    if (n == 0) return first;
+    if (static_cast<size_t>(last - first) < n) return last;
+
+    const char* stop = last - n + 1;
+    const char* p = first;
+    while (p < stop) {
+        p = static_cast<const char*>(std::memchr(p, needle[0], stop - p));
+        if (!p) return last;
+        if (std::memcmp(p + 1, needle + 1, n - 1) == 0) return p;
+        ++p;
+    }
+    return last;
+}
+
+#ifdef SUBSTRINGSCAN_X86
+// Both kernels compare a block of candidate starts against the first and the
+// last needle byte at once and only memcmp the middle of the survivors.
+static const char* findSse2(const char* first, const char* last, const char* needle, size_t n) {
+    if (n == 0) return first;
+    size_t size = static_cast<size_t>(last - first);
+    if (size < n) return last;
+
+    const __m128i head = _mm_set1_epi8(needle[0]);
+    const __m128i tail = _mm_set1_epi8(needle[n - 1]);
+    size_t i = 0;
+    for (; i + 16 + n - 1 <= size; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + i + n - 1));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, head), _mm_cmpeq_epi8(b, tail))));
+        while (mask) {
+            unsigned bit = lowestBit(mask);
+            if (n <= 2 || std::memcmp(first + i + bit + 1, needle + 1, n - 2) == 0) {
+                return first + i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return findScalar(first + i, last, needle, n);
+}
+
+SUBSTRINGSCAN_AVX2
+static const char* findAvx2(const char* first, const char* last, const char* needle, size_t n) {
+    if (n == 0) return first;
+    size_t size = static_cast<size_t>(last - first);
+    if (size < n) return last;
+
+    const __m256i head = _mm256_set1_epi8(needle[0]);
+    const __m256i tail = _mm256_set1_epi8(needle[n - 1]);
+    size_t i = 0;
+    for (; i + 32 + n - 1 <= size; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + i + n - 1));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, head), _mm256_cmpeq_epi8(b, tail))));
+        while (mask) {
+            unsigned bit = lowestBit(mask);
+            if (n <= 2 || std::memcmp(first + i + bit + 1, needle + 1, n - 2) == 0) {
+                return first + i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return findSse2(first + i, last, needle, n);
+}
+
+static bool cpuHasAvx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+struct Kernel {
+    FindFunction find;
+    const char* name;
+};
+
+static Kernel selectKernel() {
+#ifdef SUBSTRINGSCAN_X86
+    if (cpuHasAvx2()) return Kernel{findAvx2, "avx2"};
+    return Kernel{findSse2, "sse2"};
+#else
+    return Kernel{findScalar, "scalar"};
+#endif
+}
+
+static const Kernel& kernel() {
+    static const Kernel selected = selectKernel();
+    return selected;
+}
+
+const char* SubstringScan::find(const char* first, const char* last,
+                                const char* needle, size_t needleSize) {
+    return kernel().find(first, last, needle, needleSize);
+}
+
+const char* SubstringScan::implementation() {
+    return kernel().name;
+}
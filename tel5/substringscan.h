@@ -0,0 +1,17 @@
+#ifndef SUBSTRINGSCAN_H
+#define SUBSTRINGSCAN_H
+
+#include <cstddef>
+
+// Exact substring search over a byte range. Case-insensitive matching is done
+// by scanning folded text for a folded needle. The AVX2 or SSE2 kernel is
+// picked once at runtime from the CPU features, with a scalar fallback.
+class SubstringScan {
+public:
+    // First occurrence of needle in [first, last), or last if there is none.
+    static const char* find(const char* first, const char* last,
+                            const char* needle, size_t needleSize);
+    static const char* implementation();
+};
+
+#endif
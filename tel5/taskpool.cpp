@@ -0,0 +1,105 @@
+#include "taskpool.h"
+#include <algorithm>
+
+namespace {
+thread_local const TaskPool* currentPool = nullptr;
+thread_local size_t currentQueue = 0;
+}
+
+TaskPool::TaskPool(unsigned threads) : queued(0), nextQueue(0) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < threads; ++i) queues.push_back(std::make_unique<Queue>());
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& w : workers) w.join();
+}
+
+TaskPool& TaskPool::shared() {
+    static TaskPool pool;
+    return pool;
+}
+
+size_t TaskPool::homeQueue() {
+    if (currentPool == this) return currentQueue;
+    return nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+}
+
+void TaskPool::run(Group& group, std::function<void()> task) {
+    group.pending.fetch_add(1);
+    queued.fetch_add(1);
+    Queue& queue = *queues[homeQueue()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(Task{std::move(task), &group});
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+bool TaskPool::runOne(size_t home) {
+    Task task;
+    bool found = false;
+    {
+        Queue& own = *queues[home];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+    for (size_t i = 1; !found && i < queues.size(); ++i) {
+        Queue& victim = *queues[(home + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            found = true;
+        }
+    }
+    if (!found) return false;
+
+    queued.fetch_sub(1);
+    try {
+        task.fn();
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(task.group->errorMutex);
+        if (!task.group->error) task.group->error = std::current_exception();
+    }
+    task.group->pending.fetch_sub(1);
+    return true;
+}
+
+void TaskPool::wait(Group& group) {
+    size_t home = homeQueue();
+    while (group.pending.load() != 0) {
+        if (!runOne(home)) std::this_thread::yield();
+    }
+    if (group.error) {
+        std::exception_ptr error = group.error;
+        group.error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void TaskPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentQueue = index;
+    while (true) {
+        if (runOne(index)) continue;
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this]() { return stopping || queued.load() != 0; });
+        if (stopping && queued.load() == 0) return;
+    }
+}
@@ -1,140 +1,744 @@
 #include "validator.h"
-#include <QString>
-#include <QDate>
+#include "birthdate.h"
+#include "taskpool.h"
 #include <algorithm>
-#include <cctype>
 
-std::string Validator::trim(const std::string& str) {
-    QString qstr = QString::fromStdString(str);
-    return qstr.trimmed().toStdString();
+#if defined(__SSE2__) || defined(_M_X64)
+#define VALIDATOR_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Two-byte Cyrillic (U+0400..U+04FF), indexed by code point - 0x400, which is
+// (lead - 0xD0) * 64 + (continuation - 0x80). Bit n of letters[k] is set when
+// entry k * 64 + n is a letter: only U+0482..U+0489, signs and combining
+// marks, are not. lower[] holds each code point's lower-case pair.
+struct CyrillicTable {
+    uint64_t letters[4];
+    uint16_t lower[256];
+};
+
+static constexpr CyrillicTable makeCyrillicTable() {
+    CyrillicTable table{};
+    for (unsigned k = 0; k < 4; ++k) {
+        table.letters[k] = ~0ull;
+    }
+    table.letters[2] &= ~(0xFFull << 2);
+    for (unsigned cp = 0x400; cp < 0x500; ++cp) {
+        unsigned lower = cp;
+        if (cp >= 0x410 && cp <= 0x42F) {           // А..Я
+            lower = cp + 0x20;
+        } else if (cp <= 0x40F) {                   // Ѐ..Џ, including Ё
+            lower = cp + 0x50;
+        } else if ((cp >= 0x460 && cp <= 0x481) || (cp >= 0x48A && cp <= 0x4BF) || cp >= 0x4D0) {
+            lower = cp | 1;                         // pairs start at an even code point
+        } else if (cp >= 0x4C1 && cp <= 0x4CE) {
+            lower = cp + (cp & 1);                  // ... and here at an odd one
+        } else if (cp == 0x4C0) {
+            lower = 0x4CF;
+        }
+        table.lower[cp - 0x400] = static_cast<uint16_t>(lower);
+    }
+    return table;
 }
 
-bool Validator::validateName(const std::string& name) {
-    std::string t = trim(name);
-    if (t.empty()) return false;
-    
-    if (!std::isalpha(static_cast<unsigned char>(t[0]))) {
-        return false;
+static constexpr CyrillicTable cyrillic = makeCyrillicTable();
+
+static_assert(cyrillic.lower[0x401 - 0x400] == 0x451 && cyrillic.lower[0x42F - 0x400] == 0x44F, "Ё, Я");
+
+// Index into the table of the two-byte Cyrillic character at s[i], or -1.
+static int cyrillicAt(const char* s, size_t n, size_t i) {
+    unsigned lead = static_cast<unsigned char>(s[i]) - 0xD0u;
+    if (lead >= 4 || i + 1 >= n) {
+        return -1;
     }
-    
-    for (char c : t) {
-        if (!std::isalnum(static_cast<unsigned char>(c)) && c != ' ' && c != '-' && c != '\'') {
-            return false;
+    unsigned cont = static_cast<unsigned char>(s[i + 1]) ^ 0x80u;
+    return cont < 64 ? static_cast<int>(lead * 64 + cont) : -1;
+}
+
+// Writes the lower case of the character at src[i] to dst[i..] and returns
+// its length. Every Cyrillic capital is two bytes like its lower-case pair,
+// so the length is kept.
+static size_t foldAt(const char* src, size_t n, size_t i, char* dst) {
+    unsigned char c = static_cast<unsigned char>(src[i]);
+    if (c >= 'A' && c <= 'Z') {
+        dst[i] = static_cast<char>(c + 0x20);
+        return 1;
+    }
+    int k = cyrillicAt(src, n, i);
+    if (k < 0) {
+        dst[i] = src[i];
+        return 1;
+    }
+    unsigned lower = cyrillic.lower[k];
+    dst[i] = static_cast<char>(0xC0 | lower >> 6);
+    dst[i + 1] = static_cast<char>(0x80 | (lower & 0x3F));
+    return 2;
+}
+
+std::string Validator::foldCase(const std::string& str) {
+    std::string out;
+    appendFolded(out, str);
+    return out;
+}
+
+#ifdef VALIDATOR_SSE2
+static __m128i bytes(int c) {
+    return _mm_set1_epi8(static_cast<char>(c));
+}
+
+// Bytes in [lo, hi]. Compares are signed, so both bounds must lie on the same
+// side of 0x80.
+static __m128i inRange(__m128i v, int lo, int hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, bytes(lo - 1)), _mm_cmplt_epi8(v, bytes(hi + 1)));
+}
+
+// Bit masks of a 16-byte block: lead bytes of two-byte Cyrillic (0xD0..0xD3),
+// continuation bytes, and all bytes below 0x80. The block is well formed UTF-8
+// of those kinds when every lead is followed by exactly one continuation; a
+// lead in the last byte is left for the next block.
+struct BlockShape {
+    unsigned leads;
+    unsigned conts;
+    unsigned ascii;
+
+    bool wellFormed() const {
+        return (leads | conts | ascii) == 0xFFFF && conts == ((leads << 1) & 0xFFFF);
+    }
+
+    // Bytes of the block that form whole characters.
+    size_t whole() const {
+        return leads & 0x8000 ? 15 : 16;
+    }
+};
+
+static BlockShape shapeOf(__m128i v) {
+    BlockShape shape;
+    shape.leads = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(v, bytes(0xFC)), bytes(0xD0))));
+    shape.conts = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(v, bytes(0xC0)), bytes(0x80))));
+    shape.ascii = ~static_cast<unsigned>(_mm_movemask_epi8(v)) & 0xFFFF;
+    return shape;
+}
+
+// Folds a block of ASCII and Russian letters (U+0400..U+045F) in registers
+// and returns how many bytes are done, or 0, writing nothing, for anything
+// else.
+static size_t foldBlock(const char* src, char* dst) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i delta = _mm_and_si128(inRange(v, 'A', 'Z'), bytes(0x20));
+    if (_mm_movemask_epi8(v) != 0) {
+        BlockShape shape = shapeOf(v);
+        __m128i prev = _mm_slli_si128(v, 1);
+        __m128i afterD0 = _mm_cmpeq_epi8(prev, bytes(0xD0));
+        __m128i afterD1 = _mm_cmpeq_epi8(prev, bytes(0xD1));
+        __m128i extended = _mm_or_si128(_mm_and_si128(afterD1, inRange(v, 0xA0, 0xBF)), inRange(v, 0xD2, 0xFF));
+        if (!shape.wellFormed() || _mm_movemask_epi8(extended) != 0) {
+            return 0;
         }
+        // After 0xD0: 0x90..0x9F gains 0x20, 0xA0..0xAF loses 0x20 and
+        // 0x80..0x8F gains 0x10; for the last two the lead becomes 0xD1.
+        __m128i low = _mm_cmplt_epi8(v, bytes(0x90));
+        __m128i mid = inRange(v, 0x90, 0x9F);
+        __m128i high = inRange(v, 0xA0, 0xAF);
+        __m128i cont = _mm_or_si128(_mm_or_si128(_mm_and_si128(mid, bytes(0x20)), _mm_and_si128(high, bytes(0xE0))),
+                                    _mm_and_si128(low, bytes(0x10)));
+        delta = _mm_or_si128(delta, _mm_and_si128(afterD0, cont));
+        __m128i next = _mm_srli_si128(v, 1);
+        __m128i moves = _mm_or_si128(_mm_cmplt_epi8(next, bytes(0x90)), inRange(next, 0xA0, 0xAF));
+        __m128i lead = _mm_and_si128(_mm_cmpeq_epi8(v, bytes(0xD0)), moves);
+        delta = _mm_or_si128(delta, _mm_and_si128(lead, bytes(1)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_add_epi8(v, delta));
+        return shape.whole();
     }
-    
-    if (t.front() == '-' || t.back() == '-') {
-        return false;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_add_epi8(v, delta));
+    return 16;
+}
+#endif
+
+// 16-byte blocks of ASCII and Russian text are folded with SSE2; any other
+// block goes through foldAt.
+static void foldInto(char* dst, std::string_view str) {
+    const char* src = str.data();
+    size_t n = str.size();
+    size_t i = 0;
+    while (i < n) {
+#ifdef VALIDATOR_SSE2
+        while (i + 16 <= n) {
+            size_t done = foldBlock(src + i, dst + i);
+            if (done == 0) {
+                break;
+            }
+            i += done;
+        }
+        size_t stop = std::min(n, i + 16);
+#else
+        size_t stop = n;
+#endif
+        while (i < stop) {
+            i += foldAt(src, n, i, dst);
+        }
     }
-    
-    if (t.find("--") != std::string::npos) {
-        return false;
+}
+
+void Validator::appendFolded(std::string& out, std::string_view str) {
+    size_t start = out.size();
+    out.resize(start + str.size());
+    foldInto(&out[start], str);
+}
+
+void Validator::appendFolded(std::pmr::string& out, std::string_view str) {
+    size_t start = out.size();
+    out.resize(start + str.size());
+    foldInto(&out[start], str);
+}
+
+std::string_view Validator::trimmed(std::string_view str) {
+    const char* space = " \t\r\n\v\f";
+    size_t start = str.find_first_not_of(space);
+    if (start == std::string_view::npos) {
+        return std::string_view();
     }
-    
-    return true;
+    size_t end = str.find_last_not_of(space);
+    return str.substr(start, end - start + 1);
 }
 
-bool Validator::validateEmail(const std::string& email) {
-    std::string t = trim(email);
-    if (t.empty()) return false;
+static bool isAsciiLetter(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
 
-    size_t atPos = t.find('@');
-    if (atPos == std::string::npos || atPos == 0 || atPos == t.length() - 1) {
-        return false;
+static bool isAsciiDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Length of the letter starting at t[i]: an ASCII letter or a two-byte
+// Cyrillic one, or 0 if there is none.
+static size_t letterAt(std::string_view t, size_t i) {
+    if (isAsciiLetter(t[i])) {
+        return 1;
     }
-    
-    size_t dotPos = t.rfind('.');
-    if (dotPos == std::string::npos || dotPos <= atPos + 1 || dotPos == t.length() - 1) {
-        return false;
+    int k = cyrillicAt(t.data(), t.size(), i);
+    return k >= 0 && (cyrillic.letters[k / 64] >> (k % 64) & 1) ? 2 : 0;
+}
+
+#ifdef VALIDATOR_SSE2
+// Skips whole 16-byte blocks of name characters: ASCII letters, digits,
+// spaces, apostrophes, hyphens that do not follow another hyphen, and
+// two-byte Cyrillic letters. Stops at the first block the scalar loop has to
+// look at, and always leaves it the last byte of t, where a hyphen is wrong.
+static size_t skipNameBlocks(std::string_view t, size_t i) {
+    const char* p = t.data();
+    while (i + 16 < t.size()) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        // Bytes >= 0x80 are negative here, so they match none of the ASCII ranges.
+        __m128i letter = inRange(_mm_or_si128(v, bytes(0x20)), 'a', 'z');
+        __m128i hyphen = _mm_cmpeq_epi8(v, bytes('-'));
+        __m128i other = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, bytes(' ')), _mm_cmpeq_epi8(v, bytes('\''))),
+                                     inRange(v, '0', '9'));
+        unsigned allowed = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letter, hyphen), other)));
+        unsigned hyphens = static_cast<unsigned>(_mm_movemask_epi8(hyphen));
+        unsigned afterHyphen = hyphens << 1 | (i > 0 && p[i - 1] == '-');
+        if (hyphens & afterHyphen) {
+            break;
+        }
+        if (allowed == 0xFFFF) {
+            i += 16;
+            continue;
+        }
+
+        BlockShape shape = shapeOf(v);
+        if ((allowed | ~shape.ascii) != 0xFFFFFFFFu || !shape.wellFormed()) {
+            break;
+        }
+        // U+0482..U+0489 are the only non-letters among the pairs.
+        __m128i afterD2 = _mm_cmpeq_epi8(_mm_slli_si128(v, 1), bytes(0xD2));
+        if (_mm_movemask_epi8(_mm_and_si128(afterD2, inRange(v, 0x82, 0x89))) != 0) {
+            break;
+        }
+        i += shape.whole();
     }
+    return i;
+}
+#endif
 
-    for (char c : t) {
-        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '@' && c != '.' && c != '_' && c != '-') {
-            return false;
+static ValidationError scanName(std::string_view t) {
+    if (t.empty()) {
+        return ValidationError::Empty;
+    }
+    if (letterAt(t, 0) == 0) {
+        return ValidationError::BadCharacter;
+    }
+
+    size_t i = 0;
+    while (i < t.size()) {
+#ifdef VALIDATOR_SSE2
+        i = skipNameBlocks(t, i);
+        size_t stop = std::min(t.size(), i + 16);
+#else
+        size_t stop = t.size();
+#endif
+        while (i < stop) {
+            char c = t[i];
+            if (c == '-') {
+                if (i == t.size() - 1 || t[i - 1] == '-') {
+                    return ValidationError::BadHyphen;
+                }
+                ++i;
+            } else if (isAsciiDigit(c) || c == ' ' || c == '\'') {
+                ++i;
+            } else {
+                size_t letter = letterAt(t, i);
+                if (letter == 0) {
+                    return ValidationError::BadCharacter;
+                }
+                i += letter;
+            }
         }
     }
-    
-    return true;
+    return ValidationError::None;
 }
 
-bool Validator::validatePhone(const std::string& phone) {
-    std::string t = trim(phone);
-    if (t.empty()) return false;
-    
-    std::string digits;
-    for (char c : t) {
-        if (std::isdigit(static_cast<unsigned char>(c))) {
-            digits += c;
+// Character classes and states of the email DFA. The local part ends at the
+// first '@'. Anything but Latin letters, digits, '_', '-', '.' and '@' is a
+// bad character. The domain needs a '.' that is neither its first nor its
+// last character.
+enum EmailClass { Word, Dot, At, Other, emailClassCount };
+enum EmailState {
+    Start, Local, AtFirst, AfterAt, Domain, DomainDot, LeadDot, LeadDotWord, DomainOk, emailStateCount
+};
+
+// A transition: the next state in the low nibble, plus what the character
+// means for the result.
+enum EmailAction { BadChar = 0x10, LocalChar = 0x20, DomainStart = 0x40 };
+
+struct EmailDfa {
+    uint8_t classes[256];
+    uint8_t next[emailStateCount][emailClassCount];
+};
+
+static constexpr uint8_t emailStep(int state, int cls) {
+    int bad = cls == Other ? BadChar : 0;
+    switch (state) {
+    case Start:
+        return cls == At ? AtFirst : Local | LocalChar | bad;
+    case Local:
+        return cls == At ? AfterAt : Local | LocalChar | bad;
+    case AtFirst:
+        return AtFirst;
+    case AfterAt:
+        return (cls == Dot ? LeadDot : Domain) | DomainStart | bad;
+    case LeadDot:
+    case LeadDotWord:
+        return cls == Dot ? DomainDot : LeadDotWord | bad;
+    case Domain:
+        return cls == Dot ? DomainDot : Domain | bad;
+    default:
+        return cls == Dot ? DomainDot : DomainOk | bad;
+    }
+}
+
+static constexpr EmailDfa makeEmailDfa() {
+    EmailDfa dfa{};
+    for (int c = 0; c < 256; ++c) {
+        bool word = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+        dfa.classes[c] = word ? Word : c == '.' ? Dot : c == '@' ? At : Other;
+    }
+    for (int state = 0; state < emailStateCount; ++state) {
+        for (int cls = 0; cls < emailClassCount; ++cls) {
+            dfa.next[state][cls] = emailStep(state, cls);
         }
     }
-    
-    if (digits.substr(0, 2) == "+7") {
-        digits = "8" + digits.substr(2);
-    } else if (digits[0] == '7') {
-        digits = "8" + digits.substr(1);
+    return dfa;
+}
+
+static constexpr EmailDfa emailDfa = makeEmailDfa();
+
+// The DFA partway through an email. feed() can be called once per piece, so
+// an email stored in two parts is checked without joining them.
+struct EmailScan {
+    unsigned state = Start;
+    unsigned flags = 0;
+    size_t length = 0;
+    size_t localEnd = 0;
+    size_t domainStart = 0;
+
+    void feed(std::string_view t) {
+        for (size_t i = 0; i < t.size(); ++i) {
+            uint8_t step = emailDfa.next[state][emailDfa.classes[static_cast<unsigned char>(t[i])]];
+            state = step & 0x0F;
+            flags |= step;
+            if (step & LocalChar) {
+                localEnd = length + i + 1;
+            }
+            if (step & DomainStart) {
+                domainStart = length + i;
+            }
+        }
+        length += t.size();
     }
 
-    if (digits.length() != 11 || digits[0] != '8') {
-        return false;
+    ValidationError result() const {
+        if (length == 0) {
+            return ValidationError::Empty;
+        }
+        if (state <= AfterAt) {
+            return ValidationError::MissingAt;
+        }
+        if (state != DomainOk) {
+            return ValidationError::BadDomain;
+        }
+        if (flags & BadChar) {
+            return ValidationError::BadCharacter;
+        }
+        return ValidationError::None;
     }
+};
 
-    for (char c : digits) {
-        if (!std::isdigit(static_cast<unsigned char>(c))) {
-            return false;
+// Runs the DFA over t once. On success local and domain view into t.
+static ValidationError scanEmail(std::string_view t, std::string_view& local, std::string_view& domain) {
+    EmailScan scan;
+    scan.feed(t);
+    ValidationError error = scan.result();
+    if (error != ValidationError::None) {
+        return error;
+    }
+    local = t.substr(0, scan.localEnd);
+    domain = t.substr(scan.domainStart);
+    return ValidationError::None;
+}
+
+// Calling codes the phone book accepts, with the length range of the
+// national number that follows each. E.164 codes are prefix-free, so a trie
+// over their digits finds the code in at most three steps.
+struct PhoneCountry {
+    uint16_t code;
+    uint8_t minDigits;
+    uint8_t maxDigits;
+};
+
+static constexpr PhoneCountry phoneCountries[] = {
+    {1, 10, 10},    {7, 10, 10},    {30, 10, 10},   {31, 9, 9},     {32, 8, 9},
+    {33, 9, 9},     {34, 9, 9},     {36, 8, 9},     {39, 6, 11},    {40, 9, 9},
+    {41, 9, 9},     {43, 4, 13},    {44, 9, 10},    {45, 8, 8},     {46, 7, 10},
+    {47, 8, 8},     {48, 9, 9},     {49, 6, 13},    {90, 10, 10},   {351, 9, 9},
+    {352, 4, 11},   {353, 7, 9},    {354, 7, 9},    {356, 8, 8},    {357, 8, 8},
+    {358, 5, 12},   {359, 8, 9},    {370, 8, 8},    {371, 8, 8},    {372, 7, 8},
+    {373, 8, 8},    {374, 8, 8},    {375, 9, 9},    {380, 9, 9},    {381, 8, 9},
+    {385, 8, 9},    {386, 8, 8},    {420, 9, 9},    {421, 9, 9},    {972, 8, 9},
+    {992, 9, 9},    {993, 8, 8},    {994, 9, 9},    {995, 9, 9},    {996, 9, 9},
+    {998, 9, 9},
+};
+
+static const int phoneCountryCount = sizeof(phoneCountries) / sizeof(phoneCountries[0]);
+static const int phoneTrieSize = 64;
+
+// next[node][digit] is the child node, 0 for none; country[node] is 1 + the
+// index of the code ending at node, 0 for an inner node.
+struct PhoneTrie {
+    uint8_t next[phoneTrieSize][10];
+    uint8_t country[phoneTrieSize];
+};
+
+static constexpr PhoneTrie makePhoneTrie() {
+    PhoneTrie trie{};
+    int nodes = 1;
+    for (int i = 0; i < phoneCountryCount; ++i) {
+        unsigned code = phoneCountries[i].code;
+        unsigned divisor = code >= 100 ? 100 : code >= 10 ? 10 : 1;
+        int node = 0;
+        for (; divisor > 0; divisor /= 10) {
+            unsigned digit = code / divisor % 10;
+            if (trie.next[node][digit] == 0) {
+                trie.next[node][digit] = static_cast<uint8_t>(nodes++);
+            }
+            node = trie.next[node][digit];
         }
+        trie.country[node] = static_cast<uint8_t>(i + 1);
     }
-    
-    return true;
+    return trie;
 }
 
-bool Validator::validateDate(const std::string& date) {
-    if (date.empty()) return true;
-    
-    std::string t = trim(date);
+static constexpr PhoneTrie phoneTrie = makePhoneTrie();
 
-    if (t.length() != 10 || t[4] != '-' || t[7] != '-') {
-        return false;
+static constexpr uint64_t powersOf10[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+// The country of an international number of the given length, found from
+// its leading digits; codeDigits is set to the length of its code.
+static const PhoneCountry* phoneCountry(uint64_t number, int digits, int& codeDigits) {
+    unsigned node = 0;
+    for (int i = 1; i <= 3 && i < digits; ++i) {
+        node = phoneTrie.next[node][number / powersOf10[digits - i] % 10];
+        if (node == 0) {
+            return nullptr;
+        }
+        if (phoneTrie.country[node]) {
+            codeDigits = i;
+            return &phoneCountries[phoneTrie.country[node] - 1];
+        }
     }
-    
-    try {
-        int year = std::stoi(t.substr(0, 4));
-        int month = std::stoi(t.substr(5, 2));
-        int day = std::stoi(t.substr(8, 2));
+    return nullptr;
+}
 
-        if (year < 1900 || month < 1 || month > 12 || day < 1 || day > 31) {
-            return false;
+// 11 digits starting with 7 or 8 is a Russian number. After + or 00 comes a
+// known calling code and a national number of that country's length. Any
+// other characters are separators. On success key is the number in E.164
+// form as an integer.
+static ValidationError scanPhone(std::string_view t, uint64_t& key) {
+    if (t.empty()) {
+        return ValidationError::Empty;
+    }
+
+    uint64_t number = 0;
+    int digits = 0;
+    int zeros = 0;
+    int pluses = 0;
+    for (char c : t) {
+        if (isAsciiDigit(c)) {
+            if (c == '0' && zeros == digits) {
+                ++zeros;
+            }
+            if (++digits > 17) {
+                return ValidationError::BadLength;
+            }
+            number = number * 10 + static_cast<uint64_t>(c - '0');
+        } else if (c == '+' && digits == 0) {
+            ++pluses;
         }
+    }
 
-        QString qdate = QString::fromStdString(t);
-        QDate d = QDate::fromString(qdate, "yyyy-MM-dd");
-        if (!d.isValid() || d >= QDate::currentDate()) {
-            return false;
+    if (pluses > 1 || (pluses == 1 && zeros > 0)) {
+        return ValidationError::BadPrefix;
+    }
+    if (pluses == 0 && zeros != 2) {
+        if (digits != 11) {
+            return ValidationError::BadLength;
         }
-        
-        return true;
-    } catch (...) {
-        return false;
+        uint64_t lead = number / powersOf10[10];
+        if (lead != 7 && lead != 8) {
+            return ValidationError::BadPrefix;
+        }
+        key = 7 * powersOf10[10] + number % powersOf10[10];
+        return ValidationError::None;
+    }
+
+    digits -= zeros;
+    if (digits > 15) {
+        return ValidationError::BadLength;
+    }
+    int codeDigits = 0;
+    const PhoneCountry* country = phoneCountry(number, digits, codeDigits);
+    if (!country) {
+        return ValidationError::BadPrefix;
+    }
+    if (digits - codeDigits < country->minDigits || digits - codeDigits > country->maxDigits) {
+        return ValidationError::BadLength;
+    }
+    key = number;
+    return ValidationError::None;
+}
+
+std::string Validator::trim(const std::string& str) {
+    return std::string(trimmed(str));
+}
+
+Normalized Validator::normalizeName(std::string_view name) {
+    Normalized result;
+    std::string_view t = trimmed(name);
+    result.error = scanName(t);
+    if (result) {
+        result.value.assign(t.data(), t.size());
+    }
+    return result;
+}
+
+Normalized Validator::normalizeEmail(std::string_view email) {
+    Normalized result;
+    std::string_view t = trimmed(email);
+    std::string_view local, domain;
+    result.error = scanEmail(t, local, domain);
+    if (result) {
+        result.value.assign(t.data(), t.size());
+        result.domain = local.size() + 1;
+    }
+    return result;
+}
+
+Normalized Validator::normalizePhone(std::string_view phone) {
+    Normalized result;
+    uint64_t key;
+    result.error = scanPhone(trimmed(phone), key);
+    if (result) {
+        result.value = formatPhone(key);
     }
+    return result;
+}
+
+const char* Validator::errorName(ValidationError error) {
+    switch (error) {
+    case ValidationError::None:
+        return "ok";
+    case ValidationError::Empty:
+        return "empty";
+    case ValidationError::BadCharacter:
+        return "bad character";
+    case ValidationError::BadHyphen:
+        return "misplaced hyphen";
+    case ValidationError::MissingAt:
+        return "missing @";
+    case ValidationError::BadDomain:
+        return "bad domain";
+    case ValidationError::BadLength:
+        return "wrong length";
+    case ValidationError::BadPrefix:
+        return "bad prefix";
+    case ValidationError::BadDate:
+        return "bad date";
+    case ValidationError::MissingField:
+        return "missing field";
+    }
+    return "unknown";
+}
+
+ValidationError Validator::checkName(std::string_view name) {
+    return scanName(trimmed(name));
 }
 
-std::string Validator::normalizePhone(const std::string& phone) {
-    std::string digits;
-    for (char c : phone) {
-        if (std::isdigit(static_cast<unsigned char>(c))) {
-            digits += c;
+ValidationError Validator::checkEmail(std::string_view email) {
+    std::string_view local, domain;
+    return scanEmail(trimmed(email), local, domain);
+}
+
+// The domain part starts with '@', so trimming the joined email only ever
+// touches the front of local and the back of domain.
+ValidationError Validator::checkEmail(std::string_view local, std::string_view domain) {
+    if (domain.empty()) {
+        return checkEmail(local);
+    }
+    const char* space = " \t\r\n\v\f";
+    EmailScan scan;
+    size_t start = local.find_first_not_of(space);
+    if (start != std::string_view::npos) {
+        scan.feed(local.substr(start));
+    }
+    scan.feed(domain.substr(0, domain.find_last_not_of(space) + 1));
+    return scan.result();
+}
+
+std::vector<ValidationError> Validator::checkEmails(const std::vector<std::string_view>& emails) {
+    std::vector<ValidationError> errors(emails.size());
+    TaskPool& pool = TaskPool::shared();
+    TaskPool::Group group;
+    for (size_t begin = 0; begin < emails.size(); begin += 8192) {
+        size_t end = std::min(emails.size(), begin + 8192);
+        pool.run(group, [&emails, &errors, begin, end]() {
+            for (size_t i = begin; i < end; ++i) {
+                errors[i] = checkEmail(emails[i]);
+            }
+        });
+    }
+    pool.wait(group);
+    return errors;
+}
+
+ValidationError Validator::checkPhone(std::string_view phone) {
+    uint64_t key;
+    return scanPhone(trimmed(phone), key);
+}
+
+ValidationError Validator::checkPhone(std::string_view phone, uint64_t& key) {
+    return scanPhone(trimmed(phone), key);
+}
+
+bool Validator::validateName(const std::string& name) {
+    return checkName(name) == ValidationError::None;
+}
+
+bool Validator::validateEmail(const std::string& email) {
+    return checkEmail(email) == ValidationError::None;
+}
+
+bool Validator::validatePhone(const std::string& phone) {
+    return checkPhone(phone) == ValidationError::None;
+}
+
+// Canonical key of a number: its E.164 digits as an integer, so a Russian
+// number is 7XXXXXXXXXX whichever of +7, 7 or 8 it was written with. 0 if
+// invalid.
+uint64_t Validator::phoneKey(std::string_view phone) {
+    uint64_t key;
+    return checkPhone(phone, key) == ValidationError::None ? key : 0;
+}
+
+std::vector<uint64_t> Validator::phoneKeys(const std::vector<std::string_view>& phones) {
+    std::vector<uint64_t> keys(phones.size());
+    TaskPool& pool = TaskPool::shared();
+    TaskPool::Group group;
+    for (size_t begin = 0; begin < phones.size(); begin += 8192) {
+        size_t end = std::min(phones.size(), begin + 8192);
+        pool.run(group, [&phones, &keys, begin, end]() {
+            for (size_t i = begin; i < end; ++i) {
+                keys[i] = phoneKey(phones[i]);
+            }
+        });
+    }
+    pool.wait(group);
+    return keys;
+}
+
+std::string Validator::formatPhone(uint64_t key) {
+    if (key == 0) {
+        return std::string();
+    }
+    int digits = 1;
+    while (digits < 19 && key >= powersOf10[digits]) {
+        ++digits;
+    }
+    int codeDigits = digits;
+    const PhoneCountry* country = phoneCountry(key, digits, codeDigits);
+
+    char text[32];
+    size_t n = 0;
+    if (country && country->code == 7) {
+        // The form the book has always shown and saved for Russian numbers.
+        static const char layout[] = "8 (###) ###-##-##";
+        int digit = 9;
+        for (const char* p = layout; *p; ++p) {
+            text[n++] = *p == '#' ? static_cast<char>('0' + key / powersOf10[digit--] % 10) : *p;
         }
+        return std::string(text, n);
     }
+    text[n++] = '+';
+    for (int i = 0; i < digits; ++i) {
+        if (i == codeDigits) {
+            text[n++] = ' ';
+        }
+        text[n++] = static_cast<char>('0' + key / powersOf10[digits - 1 - i] % 10);
+    }
+    return std::string(text, n);
+}
 
-    if (digits.substr(0, 2) == "+7") {
-        digits = "8" + digits.substr(2);
-    } else if (digits[0] == '7') {
-        digits = "8" + digits.substr(1);
+bool Validator::validateDate(const std::string& date) {
+    int32_t day;
+    return checkBirthDate(date, day) == ValidationError::None;
+}
+
+ValidationError Validator::checkBirthDate(std::string_view date, int32_t& day) {
+    std::string_view t = trimmed(date);
+    if (t.empty()) {
+        day = BirthDate::none;
+        return ValidationError::None;
     }
-    
-    if (digits.length() == 11) {
-        return digits.substr(0, 1) + " (" + digits.substr(1, 3) + ") " + 
-               digits.substr(4, 3) + "-" + digits.substr(7, 2) + "-" + digits.substr(9, 2);
+    day = BirthDate::parse(t);
+    return validateBirthDay(day) ? ValidationError::None : ValidationError::BadDate;
+}
+
+bool Validator::validateBirthDay(int32_t day) {
+    if (day == BirthDate::none) {
+        return false;
     }
-    
-    return digits;
+    static const int32_t earliest = BirthDate::fromCivil(1900, 1, 1);
+    return day >= earliest && day < BirthDate::today();
 }
@@ -0,0 +1,138 @@
+// trigramindex.cpp
+#include "trigramindex.h"
+#include <algorithm>
+#include <iterator>
+
+void TrigramIndex::PostingList::append(uint64_t id) {
+    uint64_t delta = id - last;
+    while (delta >= 0x80) {
+        bytes.push_back(static_cast<uint8_t>(delta | 0x80));
+        delta >>= 7;
+    }
+    bytes.push_back(static_cast<uint8_t>(delta));
+    last = id;
+    ++count;
+}
+
+void TrigramIndex::PostingList::add(uint64_t id) {
+    auto it = std::lower_bound(removed.begin(), removed.end(), id);
+    if (it != removed.end() && *it == id) {
+        removed.erase(it);
+        return;
+    }
+    if (id > last) {
+        append(id);
+        return;
+    }
+    pending.insert(std::lower_bound(pending.begin(), pending.end(), id), id);
+    compactIfNeeded();
+}
+
+void TrigramIndex::PostingList::remove(uint64_t id) {
+    auto it = std::lower_bound(pending.begin(), pending.end(), id);
+    if (it != pending.end() && *it == id) {
+        pending.erase(it);
+        return;
+    }
+    removed.insert(std::lower_bound(removed.begin(), removed.end(), id), id);
+    compactIfNeeded();
+}
+
+void TrigramIndex::PostingList::decode(std::vector<uint64_t>& out) const {
+    auto p = pending.begin();
+    auto r = removed.begin();
+    uint64_t id = 0;
+    size_t pos = 0;
+    while (pos < bytes.size()) {
+        uint64_t delta = 0;
+        int shift = 0;
+        uint8_t b;
+        do {
+            b = bytes[pos++];
+            delta |= static_cast<uint64_t>(b & 0x7F) << shift;
+            shift += 7;
+        } while (b & 0x80);
+        id += delta;
+
+        while (p != pending.end() && *p < id) out.push_back(*p++);
+        if (r != removed.end() && *r == id) {
+            ++r;
+            continue;
+        }
+        out.push_back(id);
+    }
+    out.insert(out.end(), p, pending.end());
+}
+
+void TrigramIndex::PostingList::compactIfNeeded() {
+    if (pending.size() + removed.size() <= 32 + count / 16) return;
+
+    std::vector<uint64_t> ids;
+    ids.reserve(size());
+    decode(ids);
+    bytes.clear();
+    pending.clear();
+    removed.clear();
+    last = 0;
+    count = 0;
+    for (uint64_t id : ids) append(id);
+}
+
+void TrigramIndex::collectTrigrams(std::string_view text, std::vector<uint32_t>& out) {
+    out.clear();
+    for (size_t i = 0; i + 2 < text.size(); ++i) {
+        out.push_back(static_cast<uint32_t>(static_cast<unsigned char>(text[i])) << 16 |
+                      static_cast<uint32_t>(static_cast<unsigned char>(text[i + 1])) << 8 |
+                      static_cast<uint32_t>(static_cast<unsigned char>(text[i + 2])));
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+void TrigramIndex::add(uint64_t id, std::string_view key) {
+    std::vector<uint32_t> grams;
+    collectTrigrams(key, grams);
+    for (uint32_t t : grams) {
+        lists[t].add(id);
+    }
+}
+
+void TrigramIndex::remove(uint64_t id, std::string_view key) {
+    std::vector<uint32_t> grams;
+    collectTrigrams(key, grams);
+    for (uint32_t t : grams) {
+        auto it = lists.find(t);
+        if (it == lists.end()) continue;
+        it->second.remove(id);
+        if (it->second.size() == 0) lists.erase(it);
+    }
+}
+
+std::vector<uint64_t> TrigramIndex::candidates(const std::string& query) const {
+    std::vector<uint64_t> result;
+    if (query.size() < 3) return result;
+
+    std::vector<uint32_t> grams;
+    collectTrigrams(query, grams);
+    std::vector<const PostingList*> found;
+    for (uint32_t t : grams) {
+        auto it = lists.find(t);
+        if (it == lists.end()) return result;
+        found.push_back(&it->second);
+    }
+    std::sort(found.begin(), found.end(), [](const PostingList* a, const PostingList* b) {
+        return a->size() < b->size();
+    });
+
+    found[0]->decode(result);
+    std::vector<uint64_t> next, merged;
+    for (size_t i = 1; i < found.size() && !result.empty(); ++i) {
+        next.clear();
+        merged.clear();
+        found[i]->decode(next);
+        std::set_intersection(result.begin(), result.end(), next.begin(), next.end(),
+                              std::back_inserter(merged));
+        result.swap(merged);
+    }
+    return result;
+}
@@ -0,0 +1,53 @@
+// trigramindex.h
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Inverted index from byte trigrams of contact search keys to contact ids.
+// Posting lists hold ids, not slots, so reordering PhoneBook::contacts never
+// touches the index. Shorter queries are PhoneBook's job: it scans the
+// SearchKeyBuffer for them instead.
+class TrigramIndex {
+public:
+    void add(uint64_t id, std::string_view key);
+    void remove(uint64_t id, std::string_view key);
+    void clear() { lists.clear(); }
+
+    // Ascending ids of keys that may contain the (already folded) query, which
+    // must be at least three bytes long; the caller verifies each candidate.
+    std::vector<uint64_t> candidates(const std::string& query) const;
+
+private:
+    // Ascending ids stored as varint deltas. Ids arrive mostly in increasing
+    // order and are appended; the rare out-of-order insert or delete is kept
+    // in a small side list and folded back into the bytes by compact().
+    class PostingList {
+    public:
+        void add(uint64_t id);
+        void remove(uint64_t id);
+        void decode(std::vector<uint64_t>& out) const;
+        size_t size() const { return count + pending.size() - removed.size(); }
+
+    private:
+        std::vector<uint8_t> bytes;
+        uint64_t last = 0;
+        size_t count = 0;
+        std::vector<uint64_t> pending;
+        std::vector<uint64_t> removed;
+
+        void append(uint64_t id);
+        void compactIfNeeded();
+    };
+
+    std::map<uint32_t, PostingList> lists;
+
+    static void collectTrigrams(std::string_view text, std::vector<uint32_t>& out);
+};
+
+#endif
@@ -1,9 +1,8 @@
 // validator.cpp
 #include "validator.h"
+#include "birthdate.h"
+#include "taskpool.h"
 #include <algorithm>
-#include <cctype>
-#include <sstream>
-#include <ctime>
 
 static bool isRussianLetter(unsigned char c) {
     return (c >= 0xC0 && c <= 0xDF) ||   
@@ -24,93 +23,440 @@ static bool isDigit(char c) {
     return c >= '0' && c <= '9';
 }
 
-std::string Validator::trim(const std::string& str) {
+static char foldChar(char ch) {
+    unsigned char c = static_cast<unsigned char>(ch);
+    if ((c >= 'A' && c <= 'Z') || (c >= 0xC0 && c <= 0xDF)) return static_cast<char>(c + 0x20);
+    if (c == 0xA8) return static_cast<char>(0xB8);
+    return ch;
+}
+
+
+std::string Validator::foldCase(const std::string& str) {
+    std::string out;
+    appendFolded(out, str);
+    return out;
+}
+
+static void foldInto(char* dst, std::string_view str) {
+    for (size_t i = 0; i < str.size(); ++i) {
+        dst[i] = foldChar(str[i]);
+    }
+}
+
+void Validator::appendFolded(std::string& out, std::string_view str) {
+    size_t start = out.size();
+    out.resize(start + str.size());
+    foldInto(&out[start], str);
+}
+
+void Validator::appendFolded(std::pmr::string& out, std::string_view str) {
+    size_t start = out.size();
+    out.resize(start + str.size());
+    foldInto(&out[start], str);
+}
+
+std::string_view Validator::trimmed(std::string_view str) {
     size_t start = str.find_first_not_of(" \t");
-    if (start == std::string::npos) return "";
+    if (start == std::string_view::npos) return std::string_view();
     size_t end = str.find_last_not_of(" \t");
     return str.substr(start, end - start + 1);
 }
 
-bool Validator::validateName(const std::string& name) {
-    std::string t = trim(name);
-    if (t.empty()) return false;
+static ValidationError scanName(std::string_view t) {
+    if (t.empty()) return ValidationError::Empty;
+    if (!isLetter(t[0])) return ValidationError::BadCharacter;
 
-    if (!isLetter(t[0])) return false;
+    for (size_t i = 1; i < t.size(); ++i) {
+        char c = t[i];
+        if (c == '-') {
+            if (i == t.size() - 1 || t[i - 1] == '-') return ValidationError::BadHyphen;
+        } else if (!isLetter(c) && !isDigit(c) && c != ' ') {
+            return ValidationError::BadCharacter;
+        }
+    }
+    return ValidationError::None;
+}
 
-    for (size_t i = 0; i < t.size(); ++i) {
-        unsigned char c = static_cast<unsigned char>(t[i]);
+// Character classes and states of the email DFA. The local part ends at the
+// first '@', and spaces right before or after it are dropped. Spaces anywhere
+// else are bad characters, like anything but Latin letters, digits, '_',
+// '-', '.' and '@'. The domain needs a '.' that is neither its first nor its
+// last character.
+enum EmailClass { Word, Dot, At, Space, Other, emailClassCount };
+enum EmailState {
+    Start, Local, LocalSpace, AtFirst, AfterAt, Domain, DomainDot, LeadDot, LeadDotWord, DomainOk, emailStateCount
+};
 
-        if (!isLetter(c) && !isDigit(c) && c != ' ' && c != '-') {
-            return false;
-        }
+// A transition: the next state in the low nibble, plus what the character
+// means for the result.
+enum EmailAction { BadChar = 0x10, LocalChar = 0x20, DomainStart = 0x40 };
 
-        if (c == '-' && (i == 0 || i == t.size() - 1)) return false;
+struct EmailDfa {
+    uint8_t classes[256];
+    uint8_t next[emailStateCount][emailClassCount];
+};
 
-        if (c == '-' && i > 0 && t[i - 1] == '-') return false;
+static constexpr uint8_t emailStep(int state, int cls) {
+    int bad = cls == Other || cls == Space ? BadChar : 0;
+    switch (state) {
+    case Start: return cls == At ? AtFirst : Local | LocalChar | bad;
+    case Local:
+        if (cls == At) return AfterAt;
+        return cls == Space ? LocalSpace : Local | LocalChar | bad;
+    case LocalSpace:
+        // The spaces were inside the local part after all.
+        if (cls == At) return AfterAt;
+        return cls == Space ? LocalSpace : Local | LocalChar | BadChar;
+    case AtFirst: return AtFirst;
+    case AfterAt:
+        if (cls == Space) return AfterAt;
+        return (cls == Dot ? LeadDot : Domain) | DomainStart | bad;
+    case LeadDot:
+    case LeadDotWord: return cls == Dot ? DomainDot : LeadDotWord | bad;
+    case Domain: return cls == Dot ? DomainDot : Domain | bad;
+    default: return cls == Dot ? DomainDot : DomainOk | bad;
     }
+}
 
-    return true;
+static constexpr EmailDfa makeEmailDfa() {
+    EmailDfa dfa{};
+    for (int c = 0; c < 256; ++c) {
+        bool word = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+        dfa.classes[c] = word ? Word : c == '.' ? Dot : c == '@' ? At : c == ' ' ? Space : Other;
+    }
+    for (int state = 0; state < emailStateCount; ++state) {
+        for (int cls = 0; cls < emailClassCount; ++cls) dfa.next[state][cls] = emailStep(state, cls);
+    }
+    return dfa;
 }
 
-bool Validator::validateEmail(const std::string& email) {
-    std::string t = trim(email);
-    if (t.empty()) return false;
+static constexpr EmailDfa emailDfa = makeEmailDfa();
 
-    size_t at = t.find('@');
-    if (at == std::string::npos || at == 0 || at == t.size() - 1) return false;
+// The DFA partway through an email. feed() can be called once per piece, so
+// an email stored in two parts is checked without joining them.
+struct EmailScan {
+    unsigned state = Start;
+    unsigned flags = 0;
+    size_t length = 0;
+    size_t localEnd = 0;
+    size_t domainStart = 0;
 
-    while (at > 0 && t[at - 1] == ' ') { t.erase(at - 1, 1); --at; }
-    while (at + 1 < t.size() && t[at + 1] == ' ') t.erase(at + 1, 1);
+    void feed(std::string_view t) {
+        for (size_t i = 0; i < t.size(); ++i) {
+            uint8_t step = emailDfa.next[state][emailDfa.classes[static_cast<unsigned char>(t[i])]];
+            state = step & 0x0F;
+            flags |= step;
+            if (step & LocalChar) localEnd = length + i + 1;
+            if (step & DomainStart) domainStart = length + i;
+        }
+        length += t.size();
+    }
+
+    ValidationError result() const {
+        if (length == 0) return ValidationError::Empty;
+        if (state <= AfterAt) return ValidationError::MissingAt;
+        if (state != DomainOk) return ValidationError::BadDomain;
+        if (flags & BadChar) return ValidationError::BadCharacter;
+        return ValidationError::None;
+    }
+};
 
-    size_t dot = t.rfind('.');
-    if (dot == std::string::npos || dot <= at + 1 || dot == t.size() - 1) return false;
+// Runs the DFA over t once. On success local and domain view into t.
+static ValidationError scanEmail(std::string_view t, std::string_view& local, std::string_view& domain) {
+    EmailScan scan;
+    scan.feed(t);
+    ValidationError error = scan.result();
+    if (error != ValidationError::None) return error;
+    local = t.substr(0, scan.localEnd);
+    domain = t.substr(scan.domainStart);
+    return ValidationError::None;
+}
 
-    for (char c : t) {
-        if (!isalnum(c) && c != '@' && c != '.' && c != '_' && c != '-') return false;
+// Calling codes the phone book accepts, with the length range of the
+// national number that follows each. E.164 codes are prefix-free, so a trie
+// over their digits finds the code in at most three steps.
+struct PhoneCountry {
+    uint16_t code;
+    uint8_t minDigits;
+    uint8_t maxDigits;
+};
+
+static constexpr PhoneCountry phoneCountries[] = {
+    {1, 10, 10},    {7, 10, 10},    {30, 10, 10},   {31, 9, 9},     {32, 8, 9},
+    {33, 9, 9},     {34, 9, 9},     {36, 8, 9},     {39, 6, 11},    {40, 9, 9},
+    {41, 9, 9},     {43, 4, 13},    {44, 9, 10},    {45, 8, 8},     {46, 7, 10},
+    {47, 8, 8},     {48, 9, 9},     {49, 6, 13},    {90, 10, 10},   {351, 9, 9},
+    {352, 4, 11},   {353, 7, 9},    {354, 7, 9},    {356, 8, 8},    {357, 8, 8},
+    {358, 5, 12},   {359, 8, 9},    {370, 8, 8},    {371, 8, 8},    {372, 7, 8},
+    {373, 8, 8},    {374, 8, 8},    {375, 9, 9},    {380, 9, 9},    {381, 8, 9},
+    {385, 8, 9},    {386, 8, 8},    {420, 9, 9},    {421, 9, 9},    {972, 8, 9},
+    {992, 9, 9},    {993, 8, 8},    {994, 9, 9},    {995, 9, 9},    {996, 9, 9},
+    {998, 9, 9},
+};
+
+static const int phoneCountryCount = sizeof(phoneCountries) / sizeof(phoneCountries[0]);
+static const int phoneTrieSize = 64;
+
+// next[node][digit] is the child node, 0 for none; country[node] is 1 + the
+// index of the code ending at node, 0 for an inner node.
+struct PhoneTrie {
+    uint8_t next[phoneTrieSize][10];
+    uint8_t country[phoneTrieSize];
+};
+
+static constexpr PhoneTrie makePhoneTrie() {
+    PhoneTrie trie{};
+    int nodes = 1;
+    for (int i = 0; i < phoneCountryCount; ++i) {
+        unsigned code = phoneCountries[i].code;
+        unsigned divisor = code >= 100 ? 100 : code >= 10 ? 10 : 1;
+        int node = 0;
+        for (; divisor > 0; divisor /= 10) {
+            unsigned digit = code / divisor % 10;
+            if (trie.next[node][digit] == 0) trie.next[node][digit] = static_cast<uint8_t>(nodes++);
+            node = trie.next[node][digit];
+        }
+        trie.country[node] = static_cast<uint8_t>(i + 1);
     }
-    return true;
+    return trie;
 }
 
-bool Validator::validatePhone(const std::string& phone) {
-    std::string t = trim(phone);
-    if (t.empty()) return false;
+static constexpr PhoneTrie phoneTrie = makePhoneTrie();
 
-    std::string digits;
+static constexpr uint64_t powersOf10[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+// The country of an international number of the given length, found from
+// its leading digits; codeDigits is set to the length of its code.
+static const PhoneCountry* phoneCountry(uint64_t number, int digits, int& codeDigits) {
+    unsigned node = 0;
+    for (int i = 1; i <= 3 && i < digits; ++i) {
+        node = phoneTrie.next[node][number / powersOf10[digits - i] % 10];
+        if (node == 0) return nullptr;
+        if (phoneTrie.country[node]) {
+            codeDigits = i;
+            return &phoneCountries[phoneTrie.country[node] - 1];
+        }
+    }
+    return nullptr;
+}
+
+// 11 digits starting with 7 or 8 is a Russian number. After + or 00 comes a
+// known calling code and a national number of that country's length. Any
+// other characters are separators. On success key is the number in E.164
+// form as an integer.
+static ValidationError scanPhone(std::string_view t, uint64_t& key) {
+    if (t.empty()) return ValidationError::Empty;
+
+    uint64_t number = 0;
+    int digits = 0;
+    int zeros = 0;
+    int pluses = 0;
     for (char c : t) {
-        if (isdigit(c)) digits += c;
-        else if (c == '+' && digits.empty()) digits += '+';
+        if (isDigit(c)) {
+            if (c == '0' && zeros == digits) ++zeros;
+            if (++digits > 17) return ValidationError::BadLength;
+            number = number * 10 + static_cast<uint64_t>(c - '0');
+        } else if (c == '+' && digits == 0) {
+            ++pluses;
+        }
     }
 
-    if (digits.substr(0, 2) == "+7") digits = "8" + digits.substr(2);
-    else if (digits[0] == '7') digits = "8" + digits.substr(1);
+    if (pluses > 1 || (pluses == 1 && zeros > 0)) return ValidationError::BadPrefix;
+    if (pluses == 0 && zeros != 2) {
+        if (digits != 11) return ValidationError::BadLength;
+        uint64_t lead = number / powersOf10[10];
+        if (lead != 7 && lead != 8) return ValidationError::BadPrefix;
+        key = 7 * powersOf10[10] + number % powersOf10[10];
+        return ValidationError::None;
+    }
 
-    if (digits.size() != 11 || digits[0] != '8') return false;
-    return std::all_of(digits.begin() + 1, digits.end(), ::isdigit);
+    digits -= zeros;
+    if (digits > 15) return ValidationError::BadLength;
+    int codeDigits = 0;
+    const PhoneCountry* country = phoneCountry(number, digits, codeDigits);
+    if (!country) return ValidationError::BadPrefix;
+    if (digits - codeDigits < country->minDigits || digits - codeDigits > country->maxDigits) {
+        return ValidationError::BadLength;
+    }
+    key = number;
+    return ValidationError::None;
 }
 
-bool Validator::validateDate(const std::string& date) {
-    if (date.empty()) return true;
+std::string Validator::trim(const std::string& str) {
+    return std::string(trimmed(str));
+}
+
+Normalized Validator::normalizeName(std::string_view name) {
+    Normalized result;
+    std::string_view t = trimmed(name);
+    result.error = scanName(t);
+    if (result) result.value.assign(t.data(), t.size());
+    return result;
+}
+
+Normalized Validator::normalizeEmail(std::string_view email) {
+    Normalized result;
+    std::string_view local, domain;
+    result.error = scanEmail(trimmed(email), local, domain);
+    if (!result) return result;
+
+    result.value.reserve(local.size() + 1 + domain.size());
+    result.value.append(local.data(), local.size());
+    result.value += '@';
+    result.value.append(domain.data(), domain.size());
+    result.domain = local.size() + 1;
+    return result;
+}
 
-    int y, m, d;
-    char c1, c2;
-    std::istringstream iss(date);
-    if (!(iss >> y >> c1 >> m >> c2 >> d) || c1 != '-' || c2 != '-') return false;
-    if (y < 1900 || m < 1 || m > 12 || d < 1 || d > 31) return false;
+Normalized Validator::normalizePhone(std::string_view phone) {
+    Normalized result;
+    uint64_t key;
+    result.error = scanPhone(trimmed(phone), key);
+    if (result) result.value = formatPhone(key);
+    return result;
+}
+
+const char* Validator::errorName(ValidationError error) {
+    switch (error) {
+    case ValidationError::None: return "ok";
+    case ValidationError::Empty: return "empty";
+    case ValidationError::BadCharacter: return "bad character";
+    case ValidationError::BadHyphen: return "misplaced hyphen";
+    case ValidationError::MissingAt: return "missing @";
+    case ValidationError::BadDomain: return "bad domain";
+    case ValidationError::BadLength: return "wrong length";
+    case ValidationError::BadPrefix: return "bad prefix";
+    case ValidationError::BadDate: return "bad date";
+    case ValidationError::MissingField: return "missing field";
+    }
+    return "unknown";
+}
 
-    static int days[] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-    if (m == 2 && ((y % 4 == 0 && y % 100 != 0) || y % 400 == 0)) days[2] = 29;
-    if (d > days[m]) return false;
+ValidationError Validator::checkName(std::string_view name) {
+    return scanName(trimmed(name));
+}
 
-    time_t rawtime;
-    struct tm* timeinfo;
-    time(&rawtime);
-    timeinfo = localtime(&rawtime);
+ValidationError Validator::checkEmail(std::string_view email) {
+    std::string_view local, domain;
+    return scanEmail(trimmed(email), local, domain);
+}
 
-    int cy = timeinfo->tm_year + 1900;
-    int cm = timeinfo->tm_mon + 1;
-    int cd = timeinfo->tm_mday;
+// The domain part starts with '@', so trimming the joined email only ever
+// touches the front of local and the back of domain.
+ValidationError Validator::checkEmail(std::string_view local, std::string_view domain) {
+    if (domain.empty()) return checkEmail(local);
+    EmailScan scan;
+    size_t start = local.find_first_not_of(" \t");
+    if (start != std::string_view::npos) scan.feed(local.substr(start));
+    scan.feed(domain.substr(0, domain.find_last_not_of(" \t") + 1));
+    return scan.result();
+}
+
+std::vector<ValidationError> Validator::checkEmails(const std::vector<std::string_view>& emails) {
+    std::vector<ValidationError> errors(emails.size());
+    TaskPool& pool = TaskPool::shared();
+    TaskPool::Group group;
+    for (size_t begin = 0; begin < emails.size(); begin += 8192) {
+        size_t end = std::min(emails.size(), begin + 8192);
+        pool.run(group, [&emails, &errors, begin, end]() {
+            for (size_t i = begin; i < end; ++i) errors[i] = checkEmail(emails[i]);
+        });
+    }
+    pool.wait(group);
+    return errors;
+}
+
+ValidationError Validator::checkPhone(std::string_view phone) {
+    uint64_t key;
+    return scanPhone(trimmed(phone), key);
+}
+
+ValidationError Validator::checkPhone(std::string_view phone, uint64_t& key) {
+    return scanPhone(trimmed(phone), key);
+}
+
+bool Validator::validateName(const std::string& name) {
+    return checkName(name) == ValidationError::None;
+}
 
-    if (y > cy || (y == cy && m > cm) || (y == cy && m == cm && d >= cd)) return false;
+bool Validator::validateEmail(const std::string& email) {
+    return checkEmail(email) == ValidationError::None;
+}
+
+bool Validator::validatePhone(const std::string& phone) {
+    return checkPhone(phone) == ValidationError::None;
+}
+
+// Canonical key of a number: its E.164 digits as an integer, so a Russian
+// number is 7XXXXXXXXXX whichever of +7, 7 or 8 it was written with. 0 if
+// invalid.
+uint64_t Validator::phoneKey(std::string_view phone) {
+    uint64_t key;
+    return checkPhone(phone, key) == ValidationError::None ? key : 0;
+}
+
+std::vector<uint64_t> Validator::phoneKeys(const std::vector<std::string_view>& phones) {
+    std::vector<uint64_t> keys(phones.size());
+    TaskPool& pool = TaskPool::shared();
+    TaskPool::Group group;
+    for (size_t begin = 0; begin < phones.size(); begin += 8192) {
+        size_t end = std::min(phones.size(), begin + 8192);
+        pool.run(group, [&phones, &keys, begin, end]() {
+            for (size_t i = begin; i < end; ++i) keys[i] = phoneKey(phones[i]);
+        });
+    }
+    pool.wait(group);
+    return keys;
+}
+
+std::string Validator::formatPhone(uint64_t key) {
+    if (key == 0) return std::string();
+    int digits = 1;
+    while (digits < 19 && key >= powersOf10[digits]) ++digits;
+    int codeDigits = digits;
+    const PhoneCountry* country = phoneCountry(key, digits, codeDigits);
+
+    char text[32];
+    size_t n = 0;
+    if (country && country->code == 7) {
+        // The form the book has always shown and saved for Russian numbers.
+        static const char layout[] = "8 (###) ###-##-##";
+        int digit = 9;
+        for (const char* p = layout; *p; ++p) {
+            text[n++] = *p == '#' ? static_cast<char>('0' + key / powersOf10[digit--] % 10) : *p;
+        }
+        return std::string(text, n);
+    }
+    text[n++] = '+';
+    for (int i = 0; i < digits; ++i) {
+        if (i == codeDigits) text[n++] = ' ';
+        text[n++] = static_cast<char>('0' + key / powersOf10[digits - 1 - i] % 10);
+    }
+    return std::string(text, n);
+}
+
+bool Validator::validateDate(const std::string& date) {
+    int32_t day;
+    return checkBirthDate(date, day) == ValidationError::None;
+}
+
+ValidationError Validator::checkBirthDate(std::string_view date, int32_t& day) {
+    std::string_view t = trimmed(date);
+    if (t.empty()) {
+        day = BirthDate::none;
+        return ValidationError::None;
+    }
+    day = BirthDate::parse(t);
+    return validateBirthDay(day) ? ValidationError::None : ValidationError::BadDate;
+}
 
-    return true;
+bool Validator::validateBirthDay(int32_t day) {
+    if (day == BirthDate::none) return false;
+    static const int32_t earliest = BirthDate::fromCivil(1900, 1, 1);
+    return day >= earliest && day < BirthDate::today();
 }
@@ -2,15 +2,67 @@
 #ifndef VALIDATOR_H
 #define VALIDATOR_H
 
+#include <cstdint>
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <vector>
+
+enum class ValidationError {
+    None, Empty, BadCharacter, BadHyphen, MissingAt, BadDomain, BadLength, BadPrefix, BadDate, MissingField
+};
+
+// A field in its canonical form, or why it was rejected.
+struct Normalized {
+    std::string value;
+    ValidationError error = ValidationError::None;
+    size_t domain = 0;      // normalizeEmail: where the domain starts in value
+
+    explicit operator bool() const { return error == ValidationError::None; }
+};
 
 class Validator {
 public:
     static std::string trim(const std::string& str);
+    // trim() as a view into str.
+    static std::string_view trimmed(std::string_view str);
+    static std::string foldCase(const std::string& str);
+    static void appendFolded(std::string& out, std::string_view str);
+    static void appendFolded(std::pmr::string& out, std::string_view str);
+    // Trim, validate and copy out in one pass; the setters store the value.
+    static Normalized normalizeName(std::string_view name);
+    static Normalized normalizeEmail(std::string_view email);
+    // A phone comes out in formatPhone form.
+    static Normalized normalizePhone(std::string_view phone);
+    // The same checks without the copy, for fields stored earlier.
+    static ValidationError checkName(std::string_view name);
+    static ValidationError checkEmail(std::string_view email);
+    // An email split before its first '@', as Contact keeps it.
+    static ValidationError checkEmail(std::string_view local, std::string_view domain);
+    static ValidationError checkPhone(std::string_view phone);
+    // Also gives the number's phoneKey, in the same pass.
+    static ValidationError checkPhone(std::string_view phone, uint64_t& key);
+    // checkEmail over a whole import batch; large batches are split across
+    // the shared task pool.
+    static std::vector<ValidationError> checkEmails(const std::vector<std::string_view>& emails);
     static bool validateName(const std::string& name);
+    // Short English reason, for load reports.
+    static const char* errorName(ValidationError error);
     static bool validateEmail(const std::string& email);
     static bool validatePhone(const std::string& phone);
+    // E.164 number as an integer, 0 if invalid. Accepts Russian numbers as
+    // 8..., 7... or +7... and foreign ones after + or 00.
+    static uint64_t phoneKey(std::string_view phone);
+    // phoneKey over a whole import batch, on the shared task pool.
+    static std::vector<uint64_t> phoneKeys(const std::vector<std::string_view>& phones);
+    // Display and saved form of a phoneKey: the domestic "8 (XXX) XXX-XX-XX"
+    // for +7, "+CC NNN..." elsewhere, empty for 0.
+    static std::string formatPhone(uint64_t key);
     static bool validateDate(const std::string& date);
+    // Parses an optional birth date: blank gives BirthDate::none.
+    static ValidationError checkBirthDate(std::string_view date, int32_t& day);
+    // A birth date must be a real day from 1900-01-01 up to yesterday.
+    static bool validateBirthDay(int32_t day);
 };
 
 #endif 
\ No newline at end of file